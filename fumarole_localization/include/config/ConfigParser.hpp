@@ -1,6 +1,7 @@
 //
 // ConfigParser.hpp
 // Parses the config XML file and provides an interface to required attributes
+// The file is read once (thread safe) and is never changed in memory afterwards
 //
 
 #ifndef FUMAROLE_LOCALIZATION_CONFIGPARSER_HPP
@@ -10,12 +11,14 @@
 #include <memory>
 #include <boost/property_tree/ptree.hpp>
 
+#include "config/DetectorConfig.hpp"
+
 namespace Config
 {
     class ConfigParser
     {
     public:
-        /// Get a reference to the instance
+        /// Get a reference to the instance (the config file is read on the first call)
         /// \return the reference to the instance
         static ConfigParser& GetInstance();
 
@@ -26,17 +29,30 @@ namespace Config
             return m_PropertyTree->get<T>(path);
         }
 
+        /// Get the value for the config path or the default value if the path is not in the config file
+        /// \param path path separated by '.'
+        /// \param defaultValue The value to return if the path does not exist
+        template <class T>
+        T GetValue(const std::string& path, const T& defaultValue) const {
+            return m_PropertyTree->get<T>(path, defaultValue);
+        }
+
+        /// Get the typed snapshot of the config file (parsed once)
+        /// \return The snapshot. Copy and modify it to run with different params.
+        const DetectorConfig& GetDetectorConfig() const;
+
         ConfigParser(ConfigParser const&) = delete;
         void operator=(ConfigParser const&) = delete;
 
         ~ConfigParser(){}
 
     private:
-        ConfigParser() {}
+        ConfigParser();
         static void CheckAndCreateDefaultConfig();
 
     private:
         std::unique_ptr<boost::property_tree::ptree> m_PropertyTree = nullptr;
+        DetectorConfig m_DetectorConfig;
     };
 }
 
@@ -0,0 +1,113 @@
+//
+// DetectorConfig.hpp
+// Typed, immutable snapshot of the config values used by the pipeline, the detector and the evaluation
+// The config file is parsed once into a snapshot; detectors hold their own copy, so any number of them can be
+// constructed and run concurrently, each with a different config
+//
+
+#ifndef FUMAROLE_LOCALIZATION_DETECTORCONFIG_HPP
+#define FUMAROLE_LOCALIZATION_DETECTORCONFIG_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <boost/property_tree/ptree.hpp>
+
+namespace Config
+{
+    /// Params of the image processing pipeline (config.pipeline)
+    struct PipelineConfig
+    {
+        std::vector<int> HeatRanges;                // lower bounds of the heat bins in the order of the config
+        std::string ThresholdMethod = "heat";
+        int AdaptiveWindowSize = 51;
+        float AdaptiveK = 1.0;
+        bool PyramidEnabled = false;
+        int PyramidLevels = 2;
+        int PyramidRoiPadding = 16;
+        float ContourMinArea = 0.0;
+
+        /// Get the lowest heat range (255 if there are no ranges)
+        int LowestHeatRange() const;
+
+        /// Get a text that differs for any two configs that give different localizations
+        std::string Fingerprint() const;
+    };
+
+    /// Params of the classification of the localizations (config.detection)
+    struct DetectionConfig
+    {
+        float MinAreaHeatedArea = 0.0;
+        float OpenVentSearchRadius = 0.0;
+        float HiddenVentSearchRadius = 0.0;
+
+        /// Get a text that differs for any two configs that give different classifications
+        std::string Fingerprint() const;
+    };
+
+    /// Persistent cache of the detections of each image (config.cache)
+    struct CacheConfig
+    {
+        bool Enabled = false;
+        std::string Directory = "result_cache";
+    };
+
+    /// Params of the merging of the detections of overlapping frames in world coordinates (config.deduplication)
+    struct DeduplicationConfig
+    {
+        double MergeRadius = 2.0;                   // in the units of the world coordinates of the homographies
+    };
+
+    /// Params of the association of the detections of consecutive video frames into tracks (config.tracking)
+    struct TrackingConfig
+    {
+        float GateRadius = 40.0;                    // greatest distance in pixels between a predicted track and a detection
+        int MaxMissedFrames = 5;                    // frames a track is kept without a detection before it is dropped
+        float VelocitySmoothing = 0.5;              // weight of the latest motion in the velocity of a track (0 = no motion model)
+    };
+
+    /// Params of the detection server and the limits on what its clients can make it hold in memory (config.server)
+    struct ServerConfig
+    {
+        int Workers = 1;                            // worker threads detecting frames (0 in the config = one per hardware thread)
+        int MaxBatchSize = 8;                       // most queued requests a worker takes at once
+        uint64_t MaxFrameBytes = 64ull << 20;       // largest frame payload of a REQUEST_FRAME (width * height bytes)
+        int MaxConnections = 64;                    // connections served at once (each has a thread and can hold one frame)
+    };
+
+    /// Params of the evaluation against the ground truth (config.evaluation)
+    struct EvaluationConfig
+    {
+        int DetectionThresholdMin = 0;
+        int DetectionThresholdMax = 0;
+        int DetectionThresholdStep = 1;
+        float IoUThresholdStep = 0.01;
+        std::string MatchingMethod = "hungarian";
+        float MinMatchIoU = 0.0;
+        std::string IoUMode = "box";
+    };
+
+    struct DetectorConfig
+    {
+        PipelineConfig Pipeline;
+        DetectionConfig Detection;
+        CacheConfig Cache;
+        DeduplicationConfig Deduplication;
+        TrackingConfig Tracking;
+        ServerConfig Server;
+        EvaluationConfig Evaluation;
+
+        /// Read the snapshot from a parsed config
+        /// \param tree The property tree of the config file
+        /// \return The snapshot (throws if a required value is missing or invalid)
+        static DetectorConfig FromPropertyTree(const boost::property_tree::ptree& tree);
+
+        /// Read the snapshot from a config file other than the one of the ConfigParser
+        /// \param filePath The path of the XML config file
+        /// \param config Will be set to the snapshot
+        /// \return Returns false if the file could not be read or is missing required values
+        static bool Load(const std::string& filePath, DetectorConfig& config);
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_DETECTORCONFIG_HPP
@@ -8,6 +8,11 @@
 
 #include <string>
 
+// Version of the detector binary (set by CMake). Bump the project version when the detections for the same image and config change.
+#ifndef FUMAROLE_DETECTOR_VERSION
+#define FUMAROLE_DETECTOR_VERSION "dev"
+#endif
+
 namespace Config
 {
     const std::string CONFIG_DIR { "config" };
@@ -29,6 +34,8 @@ namespace Config
 
     const std::string FINAL_RESULTS_OUTPUT_DIR { "results/" };
     const std::string EVALUATION_IMAGES_OUTPUT_DIR {"evaluation/" };
+
+    const std::string DETECTOR_VERSION { FUMAROLE_DETECTOR_VERSION };
 }
 
 #endif //FUMAROLE_LOCALIZATION_CONFIG_HPP
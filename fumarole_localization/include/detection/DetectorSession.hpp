@@ -0,0 +1,117 @@
+//
+// DetectorSession.hpp
+// Long-lived detector for a stream of frames (e.g. a camera) with per-frame latency stats
+// The pipeline, its element buffers and the frame arena are built once and reused for every frame,
+// so a frame only costs the processing itself
+//
+
+#ifndef FUMAROLE_LOCALIZATION_DETECTORSESSION_HPP
+#define FUMAROLE_LOCALIZATION_DETECTORSESSION_HPP
+
+#include "detection/FumaroleDetection.hpp"
+#include "detection/FumaroleDetector.hpp"
+#include "pipeline/Pipeline.hpp"
+#include "pipeline/ContourStore.hpp"
+#include "memory/FrameArena.hpp"
+#include "config/DetectorConfig.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <iostream>
+#include <opencv2/core/core.hpp>
+
+namespace Detection
+{
+    /// Latencies of the frames detected by a session (in milliseconds)
+    struct LatencySummary
+    {
+        size_t Frames = 0;
+        double Mean = 0.0;
+        double P50 = 0.0;
+        double P95 = 0.0;
+        double P99 = 0.0;
+        double Max = 0.0;
+
+        /// Output the summary as readable text
+        /// \param os output stream
+        /// \param summary The latency summary
+        /// \return A reference to the output stream
+        friend std::ostream& operator<<(std::ostream& os, const LatencySummary& summary)
+        {
+            os << "\n--------------- Frame Latency (ms) ---------------";
+            os << "\nFrames = " << summary.Frames;
+            os << "\nMean = " << summary.Mean;
+            os << "\np50 = " << summary.P50;
+            os << "\np95 = " << summary.P95;
+            os << "\np99 = " << summary.P99;
+            os << "\nMax = " << summary.Max;
+            os << std::endl;
+
+            return os;
+        }
+    };
+
+    class DetectorSession
+    {
+    public:
+        /// Constructor with the params of the config file
+        DetectorSession();
+
+        /// Constructor
+        /// \param config The params of the pipeline and the classification (copied)
+        explicit DetectorSession(const Config::DetectorConfig& config);
+
+        ~DetectorSession() = default;
+
+        DetectorSession(const DetectorSession&) = delete;
+        DetectorSession& operator=(const DetectorSession&) = delete;
+
+        /// Recognize the fumaroles in a frame (not thread safe, use a session per thread)
+        /// \param frame The thermal frame (8-bit grayscale is used as is, 8-bit BGR is converted)
+        /// \param detections Will be set to the detections of the frame
+        /// \return Returns false if the frame has an unsupported type or could not be processed
+        bool Detect(const cv::Mat& frame, std::vector<FumaroleDetection>& detections);
+
+        /// Recognize the fumaroles in raw 8-bit grayscale pixels (the pixels are not copied)
+        /// \param data The first pixel of the first row
+        /// \param width The width of the frame in pixels
+        /// \param height The height of the frame in pixels
+        /// \param stride The number of bytes from the start of one row to the next
+        /// \param detections Will be set to the detections of the frame
+        /// \return Returns false if the frame is invalid or could not be processed
+        bool Detect(const uint8_t* data, int width, int height, size_t stride, std::vector<FumaroleDetection>& detections);
+
+        /// Get the latency stats of the frames detected since the session was created (or the stats were reset)
+        /// The percentiles are over the most recent frames only (see LATENCY_WINDOW)
+        /// \return The latency summary
+        LatencySummary GetLatencySummary() const;
+
+        /// Clear the latency stats (e.g. after warming up)
+        void ResetLatencySummary();
+
+        /// Get the number of frames that were skipped because no pixel was above the lowest heat range
+        int GetSkippedFrameCount() const;
+
+        /// The number of recent frame latencies kept for the percentiles
+        static constexpr size_t LATENCY_WINDOW { 4096 };
+
+    private:
+        void RecordLatency(double milliseconds);
+
+    private:
+        FumaroleDetector m_Detector;
+        Memory::FrameArena m_Arena;
+        Pipeline::Pipeline m_Pipeline;
+        Pipeline::ContourStore m_Localizations;
+        cv::Mat m_Gray;
+
+        // ring of the most recent latencies and the running totals over all frames
+        std::vector<double> m_Latencies;
+        size_t m_NextLatency = 0;
+        size_t m_Frames = 0;
+        double m_TotalLatency = 0.0;
+        double m_MaxLatency = 0.0;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_DETECTORSESSION_HPP
@@ -11,6 +11,7 @@
 #include <opencv2/core/types.hpp>
 
 #include "model/FumaroleType.hpp"
+#include "pipeline/ContourFeatures.hpp"
 
 namespace Detection
 {
@@ -20,6 +21,12 @@ namespace Detection
         cv::Rect BoundingBox;
         std::vector<cv::Point> Contour;
 
+        // features of the contour this detection was classified from (not set for clustered detections and ground truth)
+        Pipeline::ContourFeatures Features;
+
+        // confidence used to rank detections for average precision (peak intensity of the contour, max of the members for clustered detections)
+        float Score = 0.0;
+
         [[nodiscard]] cv::Point2f Center() const {
             return std::move(cv::Point2f{static_cast<float>(BoundingBox.x + BoundingBox.width / 2.0), static_cast<float>(BoundingBox.y + BoundingBox.height / 2.0)});
         }
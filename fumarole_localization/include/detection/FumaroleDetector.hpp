@@ -9,22 +9,38 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <functional>
+#include <memory_resource>
+#include <cstdint>
 
 #include "detection/FumaroleDetection.hpp"
+#include "detection/RunSummary.hpp"
 #include "pipeline/Pipeline.hpp"
+#include "memory/FrameArena.hpp"
+#include "io/ResultCache.hpp"
+#include "io/BatchJournal.hpp"
+#include "config/DetectorConfig.hpp"
 
 namespace Detection
 {
     // Typedef for this recognizers main output - a map where key:fileID, value: list of detections
     typedef std::map<std::string, std::vector<FumaroleDetection>> FumaroleDetectionsPerImage;
 
+    // Typedef for the callback that receives the detections of each image as soon as they are ready
+    typedef std::function<void(const std::string& fileID, const std::vector<FumaroleDetection>& detections)> DetectionSink;
+
     class FumaroleDetector
     {
     public:
-        /// Constructor
+        /// Constructor with the params of the config file
         /// \param saveIntermediateResults Pass true if intermediate results (contours, thresholds, localizations) are to be saved as iamge files
         explicit FumaroleDetector(bool saveIntermediateResults);
 
+        /// Constructor with explicit params (instead of the ones in the config file)
+        /// \param config The params of the pipeline and the classification (copied, later changes do not affect the detector)
+        /// \param saveIntermediateResults Pass true if intermediate results (contours, thresholds, localizations) are to be saved as iamge files
+        FumaroleDetector(const Config::DetectorConfig& config, bool saveIntermediateResults);
+
         /// Destructor
         ~FumaroleDetector();
 
@@ -33,35 +49,83 @@ namespace Detection
         /// \param thermalImagePath The file path to the thermal image to load
         /// \param result A reference to the detection result that will be set
         /// \return Returns true on success
-        bool DetectFumaroles(const std::string& fileID, const std::string& thermalImagePath, std::vector<Detection::FumaroleDetection> &results) const;
+        bool DetectFumaroles(const std::string& fileID, const std::string& thermalImagePath, std::vector<Detection::FumaroleDetection> &results);
 
         /// Recognize all the fumaroles in the given image set and map bounding boxes for all of them
         /// \param files A map where key = the file id, and value = the file path to the thermal image
         /// \param results A reference that will be set to a map with key = file id, and value = a vector of detections for the fumaroles
-        /// \return Returns true on success
-        bool DetectFumaroles(const std::map<std::string, std::string>& files, std::map<std::string, std::vector<FumaroleDetection>>& results) const;
+        /// \return Returns true on success (images that failed have no entry in the results)
+        bool DetectFumaroles(const std::map<std::string, std::string>& files, std::map<std::string, std::vector<FumaroleDetection>>& results);
+
+        /// Recognize all the fumaroles in the given image set and deliver the detections of each image as soon as it is done
+        /// Only the images in flight are held in memory, the results of the batch are not collected
+        /// \param files A map where key = the file id, and value = the file path to the thermal image
+        /// \param sink Called once for each image that was processed or completed in the journal (not for images that failed)
+        /// \return Returns false if the batch was stopped because the journal could not be written
+        bool DetectFumaroles(const std::map<std::string, std::string>& files, const DetectionSink& sink);
+
+        /// Recognize the fumaroles in a frame that is already decoded in memory (no file is read or written)
+        /// Reentrant: each call runs its own pipeline and arena so one detector can be used by several threads at once
+        /// \param frame The thermal frame (8-bit grayscale is used as is, 8-bit BGR is converted)
+        /// \param detections Will be set to the detections of the frame
+        /// \return Returns false if the frame has an unsupported type or could not be processed
+        bool Detect(const cv::Mat& frame, std::vector<FumaroleDetection>& detections) const;
+
+        /// Recognize the fumaroles in raw 8-bit grayscale pixels (the pixels are not copied)
+        /// \param data The first pixel of the first row
+        /// \param width The width of the frame in pixels
+        /// \param height The height of the frame in pixels
+        /// \param stride The number of bytes from the start of one row to the next
+        /// \param detections Will be set to the detections of the frame
+        /// \return Returns false if the frame is invalid or could not be processed
+        bool Detect(const uint8_t* data, int width, int height, size_t stride, std::vector<FumaroleDetection>& detections) const;
+
+        /// Journal each image as soon as its detections were delivered
+        /// Images already recorded in the journal are not processed again (the detections of the completed ones are delivered from the journal)
+        /// \param journal The opened journal (must outlive the detection runs) or null to stop journaling
+        void SetJournal(IO::BatchJournal* journal);
+
+        /// Read the images with the given loader (e.g. a cache of decoded images shared with other detectors) instead of decoding each file
+        /// \param loader The image loader or null to decode the files
+        void SetImageLoader(Pipeline::ImageLoader loader);
+
+        /// Classify the localizations of a single image that were produced by a pipeline
+        /// Reentrant as long as each thread passes its own arena
+        /// \param contours The localized contours of the image
+        /// \param arena The arena for the temporaries of the classification (released before returning, so nothing else may
+        /// still use memory from it, e.g. a pipeline arena is only passed from its localization callback or after a frame)
+        /// \return The detections (holes and heated areas) with the open and hidden vents they cluster into
+        std::vector<FumaroleDetection> ClassifyLocalizations(const Pipeline::ContourStore& contours, Memory::FrameArena& arena) const;
 
         /// Save the result detection map [maps image id -> list of fumaroles] as images with the bounding boxes drawn on top
         /// \param resultMap A map with <file_id: <list of fumarole detection results>>
         void SaveResults(const FumaroleDetectionsPerImage& resultMap) const;
 
+        /// Get the summary of all the detection runs of this detector
+        /// \return The counts of processed, skipped, cached, resumed and failed frames and the allocation counts of the frame arena
+        const RunSummary& GetRunSummary() const;
+
     private:
-        std::map<std::string, std::vector<FumaroleDetection>> ConvertLocalizations(const Pipeline::PipelineLocalizations& localizations, Model::FumaroleType type) const;
+        std::vector<FumaroleDetection> ClassifyLocalizations(const Pipeline::ContourStore& contours, std::pmr::memory_resource* resource) const;
+        std::vector<FumaroleDetection> DetectOpenVents(const std::vector<FumaroleDetection>& detections, std::pmr::memory_resource* resource) const;
+        std::vector<FumaroleDetection> DetectHiddenVents(const std::vector<FumaroleDetection>& detections, std::pmr::memory_resource* resource) const;
+        std::vector<FumaroleDetection> ClusterDetections(const std::vector<FumaroleDetection>& detections, const std::pmr::vector<size_t>& indices, float radius, Model::FumaroleType type, std::pmr::memory_resource* resource) const;
 
-        std::vector<FumaroleDetection> ClassifyLocalizations(const std::vector<std::vector<cv::Point>>& contours) const;
-        std::vector<FumaroleDetection> DetectOpenVents(const std::vector<FumaroleDetection>& detections) const;
-        std::vector<FumaroleDetection> DetectHiddenVents(const std::vector<FumaroleDetection>& detections) const;
-        std::vector<FumaroleDetection> ClusterDetections(const std::vector<FumaroleDetection>& detections, float radius, Model::FumaroleType type) const;
+        std::unique_ptr<IO::ResultCache> CreateResultCache() const;
 
-        cv::Rect EnclosingBoundingBox(const std::vector<cv::Rect>& boxes) const;
+        cv::Rect EnclosingBoundingBox(const std::pmr::vector<cv::Rect>& boxes) const;
 
-        void RadiusSearch(const std::vector<cv::Point2f>& centroids, std::map<int, std::vector<int>>& matchedIndices, float radius) const;
+        void RadiusSearch(const std::pmr::vector<cv::Point2f>& centroids, std::pmr::vector<std::pmr::vector<int>>& matchedIndices, float radius) const;
 
     private:
-        float m_MinAreaForHeatedArea;
-        float m_OpenVentSearchRadius;
-        float m_HiddenVentSearchRadius;
+        Config::DetectorConfig m_Config;
         bool m_SaveResults;
+        IO::BatchJournal* m_Journal = nullptr;
+        Pipeline::ImageLoader m_ImageLoader;
+        RunSummary m_Summary;
+
+        // per-frame temporaries of the pipeline and the classification are allocated from here
+        Memory::FrameArena m_Arena;
     };
 }
 
@@ -0,0 +1,128 @@
+//
+// FumaroleTracker.hpp
+// Associates the detections of consecutive video frames into tracks with stable IDs
+// Each track predicts its centre with a constant velocity model and is assigned at most one detection of its type
+// within the gate radius, nearest pairs first. The candidate pairs are found through a grid with cells of the gate radius
+// (sorted once per frame), so a detection is only compared against the tracks in the 3x3 cells around it.
+// A track that misses a few frames (e.g. occluded by steam) keeps its ID when the fumarole is detected again.
+//
+
+#ifndef FUMAROLE_LOCALIZATION_FUMAROLETRACKER_HPP
+#define FUMAROLE_LOCALIZATION_FUMAROLETRACKER_HPP
+
+#include "detection/FumaroleDetection.hpp"
+#include "model/FumaroleType.hpp"
+#include "config/DetectorConfig.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <opencv2/core/core.hpp>
+
+namespace Detection
+{
+    /// A fumarole followed over the frames of a sequence
+    struct FumaroleTrack
+    {
+        uint64_t ID = 0;
+        Model::FumaroleType Type = Model::UNKNOWN;
+
+        // centre of the last detection and motion in pixels per frame
+        cv::Point2f Position;
+        cv::Point2f Velocity;
+
+        cv::Rect BoundingBox;
+        float Score = 0.0;
+
+        int Hits = 0;
+        int MissedFrames = 0;
+        uint64_t FirstFrame = 0;
+        uint64_t LastFrame = 0;
+    };
+
+    /// Counts of the tracker since it was created (or reset)
+    struct TrackerStats
+    {
+        uint64_t Frames = 0;
+        uint64_t Detections = 0;
+        uint64_t TracksStarted = 0;
+        uint64_t TracksDropped = 0;
+
+        // detections assigned to a track that had missed at least one frame
+        uint64_t Redetections = 0;
+
+        /// Output the stats as readable text
+        /// \param os output stream
+        /// \param stats The tracker stats
+        /// \return A reference to the output stream
+        friend std::ostream& operator<<(std::ostream& os, const TrackerStats& stats)
+        {
+            os << "\n--------------- Tracker ---------------";
+            os << "\nFrames = " << stats.Frames;
+            os << "\nDetections = " << stats.Detections;
+            os << "\nTracks Started = " << stats.TracksStarted;
+            os << "\nTracks Dropped = " << stats.TracksDropped;
+            os << "\nRe-detections = " << stats.Redetections;
+            os << std::endl;
+
+            return os;
+        }
+    };
+
+    class FumaroleTracker
+    {
+    public:
+        /// Constructor
+        /// \param config The params of the tracking (copied)
+        explicit FumaroleTracker(const Config::TrackingConfig& config);
+
+        ~FumaroleTracker() = default;
+
+        /// Associate the detections of the next frame with the tracks (not thread safe, use a tracker per sequence)
+        /// \param detections The detections of the frame
+        /// \param trackIDs Will be set to the track ID of each detection (in the order of the detections)
+        void Update(const std::vector<FumaroleDetection>& detections, std::vector<uint64_t>& trackIDs);
+
+        /// Get the live tracks (including the ones that missed the latest frames)
+        const std::vector<FumaroleTrack>& GetTracks() const;
+
+        /// Get the counts since the tracker was created
+        const TrackerStats& GetStats() const;
+
+        /// Drop all tracks (e.g. at a cut in the video), IDs keep increasing
+        void Reset();
+
+    private:
+        // a gated track and detection pair
+        struct Candidate
+        {
+            float Cost;
+            uint32_t Track;
+            uint32_t Detection;
+        };
+
+        int64_t CellOf(float coordinate) const;
+        static uint64_t CellKey(int64_t cx, int64_t cy);
+        void BuildGrid();
+        void FindCandidates(const std::vector<FumaroleDetection>& detections);
+        void StartTrack(const FumaroleDetection& detection);
+        void UpdateTrack(FumaroleTrack& track, const FumaroleDetection& detection);
+
+    private:
+        Config::TrackingConfig m_Config;
+        std::vector<FumaroleTrack> m_Tracks;
+        uint64_t m_NextID = 1;
+        uint64_t m_Frame = 0;
+        TrackerStats m_Stats;
+
+        // buffers reused for every frame so a frame does not allocate once they have grown
+        std::vector<cv::Point2f> m_Predictions;
+        std::vector<std::pair<uint64_t, uint32_t>> m_Grid;     // (cell key, track) sorted by cell key
+        std::vector<Candidate> m_Candidates;
+        std::vector<int> m_TrackDetection;
+        std::vector<int> m_DetectionTrack;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_FUMAROLETRACKER_HPP
@@ -0,0 +1,52 @@
+//
+// RunSummary.hpp
+// Counts collected while running the detector over a set of images
+//
+
+#ifndef FUMAROLE_LOCALIZATION_RUNSUMMARY_HPP
+#define FUMAROLE_LOCALIZATION_RUNSUMMARY_HPP
+
+#include "memory/FrameArena.hpp"
+
+#include <iostream>
+
+namespace Detection
+{
+    struct RunSummary
+    {
+        int ProcessedFrames = 0;
+        int SkippedColdFrames = 0;
+
+        // frames served from / missing in the result cache (both 0 if the cache is disabled)
+        int CacheHits = 0;
+        int CacheMisses = 0;
+
+        // frames already in the journal of a previous run / frames that could not be processed
+        int ResumedFrames = 0;
+        int FailedFrames = 0;
+
+        // allocation counts of the detector's frame arena
+        Memory::AllocationStats Allocations;
+
+        /// Output the summary as readable text
+        /// \param os output stream
+        /// \param summary The run summary
+        /// \return A reference to the output stream
+        friend std::ostream& operator<<(std::ostream& os, const RunSummary& summary)
+        {
+            os << "\n--------------- Run Summary ---------------";
+            os << "\nFrames processed = " << summary.ProcessedFrames;
+            os << "\nCold frames skipped = " << summary.SkippedColdFrames;
+            os << "\nResult cache hits = " << summary.CacheHits;
+            os << "\nResult cache misses = " << summary.CacheMisses;
+            os << "\nFrames resumed from journal = " << summary.ResumedFrames;
+            os << "\nFailed frames = " << summary.FailedFrames;
+            os << "\n" << summary.Allocations;
+            os << std::endl;
+
+            return os;
+        }
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_RUNSUMMARY_HPP
@@ -0,0 +1,94 @@
+//
+// WorldDeduplicator.hpp
+// Merges the detections of overlapping frames into one record per physical fumarole
+// Detections are mapped to world coordinates with the homography of their frame and merged with the nearest feature
+// of the same type within the merge radius. Features are found through a spatial hash with cells of the merge radius,
+// so each detection only compares against the features in the 3x3 cells around it (constant time per detection).
+//
+
+#ifndef FUMAROLE_LOCALIZATION_WORLDDEDUPLICATOR_HPP
+#define FUMAROLE_LOCALIZATION_WORLDDEDUPLICATOR_HPP
+
+#include "detection/FumaroleDetection.hpp"
+#include "model/FumaroleType.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <opencv2/core/core.hpp>
+
+namespace Detection
+{
+    /// A physical fumarole observed in one or more frames
+    struct WorldFeature
+    {
+        uint64_t ID = 0;
+        Model::FumaroleType Type = Model::UNKNOWN;
+
+        // score weighted mean of the world positions of the observations
+        cv::Point2d Position;
+
+        // union of the world extents of the observations
+        cv::Rect2d Extent;
+
+        float MaxScore = 0.0;
+        int Observations = 0;
+
+        // indices of the first and last frame the feature was observed in (see WorldDeduplicator::GetFrameID)
+        uint32_t FirstFrame = 0;
+        uint32_t LastFrame = 0;
+
+        // sum of the weights of the observations (for updating the mean)
+        double Weight = 0.0;
+    };
+
+    class WorldDeduplicator
+    {
+    public:
+        /// Constructor
+        /// \param mergeRadius The greatest world distance between the centres of two observations of the same fumarole
+        explicit WorldDeduplicator(double mergeRadius);
+
+        ~WorldDeduplicator() = default;
+
+        /// Add the detections of a frame
+        /// Detections of the same frame are never merged with each other
+        /// \param fileID The ID of the frame
+        /// \param homography The homography from the pixels of the frame to world coordinates
+        /// \param detections The detections of the frame
+        void AddFrame(const std::string& fileID, const cv::Matx33d& homography, const std::vector<FumaroleDetection>& detections);
+
+        /// Get the consolidated features in the order they were first observed
+        const std::vector<WorldFeature>& GetFeatures() const;
+
+        /// Get the ID of a frame added before
+        /// \param frame The index of the frame (in the order the frames were added)
+        const std::string& GetFrameID(uint32_t frame) const;
+
+        /// Get the number of detections added
+        size_t GetObservationCount() const;
+
+        /// Save the features to a CSV file (one record per feature)
+        /// \param filePath The full path (including file extension) for the CSV file
+        /// \return Returns false if the file could not be written
+        bool SaveToCSV(const std::string& filePath) const;
+
+    private:
+        int64_t CellOf(double coordinate) const;
+        static uint64_t CellKey(int64_t cx, int64_t cy);
+        long FindNearest(Model::FumaroleType type, const cv::Point2d& position, uint32_t frame) const;
+        void MoveToCell(size_t feature, uint64_t fromKey, uint64_t toKey);
+
+    private:
+        double m_MergeRadius;
+        std::vector<WorldFeature> m_Features;
+        std::vector<std::string> m_FrameIDs;
+        size_t m_Observations = 0;
+
+        // spatial hash: cell key -> indices of the features whose position is in the cell
+        std::unordered_map<uint64_t, std::vector<uint32_t>> m_Cells;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_WORLDDEDUPLICATOR_HPP
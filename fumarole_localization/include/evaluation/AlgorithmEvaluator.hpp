@@ -8,6 +8,9 @@
 
 #include "detection/FumaroleDetection.hpp"
 #include "evaluation/Evaluation.hpp"
+#include "evaluation/MatchingEngine.hpp"
+#include "evaluation/EvaluationAccumulator.hpp"
+#include "config/DetectorConfig.hpp"
 
 #include <eigen3/Eigen/Eigen>
 #include <vector>
@@ -18,8 +21,13 @@ namespace Evaluation
     class AlgorithmEvaluator
     {
     public:
+        /// Constructor with the evaluation params of the config file
         AlgorithmEvaluator();
 
+        /// Constructor with explicit evaluation params
+        /// \param config The thresholds and the matching of the evaluation
+        explicit AlgorithmEvaluator(const Config::EvaluationConfig& config);
+
         ~AlgorithmEvaluator();
 
         /// Evaluate the results from running the detection algorithm on a set of images
@@ -28,6 +36,12 @@ namespace Evaluation
         /// \return An evaluation of the algorithm
         AlgorithmEvaluation EvaluateDetectionPipeline(const std::map<std::string, std::vector<Detection::FumaroleDetection>>& results, const std::map<std::string, std::vector<Detection::FumaroleDetection>>& truth) const;
 
+        /// Evaluate the images (in parallel) without finalizing the evaluation so it can be merged with other shards
+        /// \param results The results of running the algorithm on images where <file id: list of detections>
+        /// \param truth The ground thruth data for each file where <file id: ground truth detection>
+        /// \return The accumulated evaluation of the images
+        EvaluationAccumulator AccumulateDetectionPipeline(const std::map<std::string, std::vector<Detection::FumaroleDetection>>& results, const std::map<std::string, std::vector<Detection::FumaroleDetection>>& truth) const;
+
         /// Evaluate the results detected for a single image
         /// \param results The list of detected fumaroles
         /// \param truth The ground truth to evaluate against
@@ -48,19 +62,25 @@ namespace Evaluation
 
         static void SaveIoUEvaluationMetricsToCSV(const std::string filePath, const std::map<float, float>& metrics);
 
+        /// Save the precision recall curves of each class to a CSV file per class (one column per IoU threshold)
+        /// \param folder The folder to save the CSV files in
+        /// \param matching The matching evaluation with the curves
+        static void SavePrecisionRecallCurvesToCSV(const std::string& folder, const MatchEvaluation& matching);
+
     private:
-        void ConvertResultsToEigenVectors(const std::vector<Detection::FumaroleDetection>& results, std::vector<Eigen::Vector4f>& vectors) const;
-        void ConvertResultsToEigenVectors(const std::vector<Detection::FumaroleDetection>& detections, std::vector<Eigen::Vector2f>& vectors) const;
-        Eigen::MatrixX2f ConvertToCentroidEigenMatrix(const std::vector<Detection::FumaroleDetection>& detections) const;
-        void ComputeDetectionMetrics(const std::vector<Detection::FumaroleDetection>& results, const std::vector<Detection::FumaroleDetection>& groundTruth, std::map<int, std::tuple<int, int>>& metrics) const;
-        float ComputeIoU(const cv::Rect& r1, const cv::Rect& r2) const;
-        void ComputeIoUMetrics(const std::vector<float>& iouScores, std::map<float, float>& metrics) const;
+        Eigen::MatrixX2d ConvertToCentroidEigenMatrix(const std::vector<Detection::FumaroleDetection>& detections) const;
+        void ComputeDetectionMetrics(const std::vector<Detection::FumaroleDetection>& results, const std::vector<Detection::FumaroleDetection>& groundTruth, ThresholdHistogram& histogram) const;
+        void ComputeIoUMetrics(const std::vector<float>& iouScores, ThresholdHistogram& histogram) const;
 
     private:
         int m_DetectionThresholdMin;
         int m_DetectionThresholdMax;
         int m_DetectionThresholdStep;
         float m_IoUThresholdStep;
+        int m_IoUThresholdBins;
+        AssignmentMethod m_AssignmentMethod;
+        IoUMode m_IoUMode;
+        float m_MinMatchIoU;
     };
 }
 
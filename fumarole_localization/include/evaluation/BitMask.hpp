@@ -0,0 +1,68 @@
+//
+// BitMask.hpp
+// Bit-packed raster of a detection (its contour or its bounding box) for computing mask IoUs
+// Each row is a run of 64-bit words aligned to multiples of 64 in image x so the rows of two masks are intersected word by word
+// (AND and popcount) without any shifting
+//
+
+#ifndef FUMAROLE_LOCALIZATION_BITMASK_HPP
+#define FUMAROLE_LOCALIZATION_BITMASK_HPP
+
+#include "detection/FumaroleDetection.hpp"
+
+#include <opencv2/core/types.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Evaluation
+{
+    class BitMask
+    {
+    public:
+        BitMask() = default;
+
+        /// Rasterize a detection (the filled contour or the bounding box if it has no contour)
+        /// \param detection The detection
+        explicit BitMask(const Detection::FumaroleDetection& detection);
+
+        /// Rasterize some of the detections
+        /// \param detections The detections
+        /// \param indices The indices of the detections to rasterize
+        /// \return The masks in the order of the indices
+        static std::vector<BitMask> Rasterize(const std::vector<Detection::FumaroleDetection>& detections, const std::vector<size_t>& indices);
+
+        /// Compute the number of pixels set in both masks
+        /// \param a The first mask
+        /// \param b The second mask
+        /// \return The area of the intersection
+        static int IntersectionArea(const BitMask& a, const BitMask& b);
+
+        /// Compute the intersection over union of two masks
+        /// \param a The first mask
+        /// \param b The second mask
+        /// \return The IoU (0 if both are empty)
+        static float IoU(const BitMask& a, const BitMask& b);
+
+        /// Returns the number of pixels set
+        int Area() const { return m_Area; }
+
+        /// Returns the region of the image covered by the mask
+        const cv::Rect& Bounds() const { return m_Bounds; }
+
+    private:
+        void Allocate(const cv::Rect& bounds);
+        void SetRun(int y, int x0, int x1);
+        const uint64_t* Row(int y) const { return m_Words.data() + static_cast<size_t>(y - m_Bounds.y) * m_WordsPerRow; }
+
+    private:
+        static constexpr int WORD_BITS { 64 };
+
+        cv::Rect m_Bounds;
+        int m_FirstWord = 0;
+        int m_WordsPerRow = 0;
+        int m_Area = 0;
+        std::vector<uint64_t> m_Words;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_BITMASK_HPP
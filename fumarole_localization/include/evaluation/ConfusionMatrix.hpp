@@ -1,70 +1,82 @@
 //
 // ConfusionMatrix.hpp
 // Represents a confusion matrix for multi-class evaluation
+// The counts are a fixed size array indexed by the fumarole types so the matrix is trivially copyable and two matrices are merged by adding the arrays
 //
 
 #ifndef FUMAROLE_LOCALIZATION_CONFUSIONMATRIX_HPP
 #define FUMAROLE_LOCALIZATION_CONFUSIONMATRIX_HPP
 
-#include <vector>
-#include <string>
-#include <tuple>
+#include <array>
 #include <iostream>
 
-#ifdef __APPLE__
-    #include <eigen3/Eigen/Eigen>
-#else
-    #include <Eigen/Eigen>
-#endif
+#include "model/FumaroleType.hpp"
 
 namespace Evaluation
 {
     class ConfusionMatrix
     {
     public:
-        /// Construct the matrix with the given class labels
-        /// \param classLabels A list of class labels
-        ConfusionMatrix(const std::vector<std::string>& classLabels);
+        // all the types including unknown so any classification can be counted
+        static constexpr int NUMBER_OF_CLASSES { Model::FumaroleType::UNKNOWN + 1 };
 
-        ~ConfusionMatrix();
+        ConfusionMatrix() = default;
 
         /// Add classification count for a classification output by the classifier
-        /// \param predictedClass The name of the class that the classifier predicted
-        /// \param actualClass The name of the class that was the ground truth class
+        /// \param predictedClass The class that the classifier predicted
+        /// \param actualClass The class that was the ground truth class
         /// \param count The number of classifications made
-        void AddClassifications(const std::string& predictedClass, const std::string& actualClass, int count = 1);
+        /// Classes outside the known types (e.g. from a corrupt record) are counted as unknown
+        void AddClassifications(Model::FumaroleType predictedClass, Model::FumaroleType actualClass, int count = 1) {
+            m_Counts[ClassIndex(actualClass) * NUMBER_OF_CLASSES + ClassIndex(predictedClass)] += count;
+        }
 
         /// Returns the accuracy of the classifier
         /// \return The accuracy score
         float GetAccuracy() const;
 
         /// Returns the precision of the classifier for the given class
-        /// \param classLabel The name of the class
+        /// \param type The class
         /// \return The precision score
-        float GetPrecision(const std::string& classLabel) const;
+        float GetPrecision(Model::FumaroleType type) const;
 
         /// Returns the recall of the classifier for the given class
-        /// \param classLabel
+        /// \param type The class
         /// \return The recall score
-        float GetRecall(const std::string& classLabel) const;
+        float GetRecall(Model::FumaroleType type) const;
 
-        /// Output confusion matrix as a CSV stream
+        /// Output confusion matrix as a CSV stream (rows are the actual classes and columns the predicted classes)
         /// \param os output stream
         /// \param cm Confusion matrix
         /// \return A reference to the output stream
         friend std::ostream& operator<<(std::ostream& os, const ConfusionMatrix& cm);
 
         /// Append another confusion matrix scores
-        /// \param other The other confusion matrix (dimensions must match)
+        /// \param other The other confusion matrix
         /// \return Return the reference to this matrix with the appended matrix data
         ConfusionMatrix& operator+=(const ConfusionMatrix& other);
 
+        /// Write the counts (row by row, without the labels)
+        /// \param os The output stream
+        void Write(std::ostream& os) const;
+
+        /// Read counts written by Write
+        /// \param is The input stream
+        /// \return Returns true on success
+        bool Read(std::istream& is);
+
     private:
-        int IndexOfClass(const std::string& classLabel) const;
+        static int ClassIndex(Model::FumaroleType type) {
+            return (type >= 0 && type < NUMBER_OF_CLASSES) ? static_cast<int>(type) : static_cast<int>(Model::UNKNOWN);
+        }
+
+        int Count(int actual, int predicted) const {
+            return m_Counts[actual * NUMBER_OF_CLASSES + predicted];
+        }
 
     private:
-        std::vector<std::string> m_ClassLabels;
-        Eigen::MatrixXi m_Matrix;
+        // row major with a row per actual class
+        std::array<int, NUMBER_OF_CLASSES * NUMBER_OF_CLASSES> m_Counts {};
     };
 }
 
@@ -12,6 +12,8 @@
 
 #include "model/FumaroleType.hpp"
 #include "ConfusionMatrix.hpp"
+#include "MatchingEngine.hpp"
+#include "ThresholdHistogram.hpp"
 
 namespace Evaluation
 {
@@ -28,14 +30,16 @@ namespace Evaluation
 
         float AverageIoU = 0.0;
 
-        ConfusionMatrix ConfusionMatrix;
+        Evaluation::ConfusionMatrix ConfusionMatrix;
 
         // for evaluation of the bounding box detections (not the classification - class labels)
-        // each key is the bin number and the value is the count
+        // the location errors and IoUs of the detections are counted in fixed threshold bins
+        ThresholdHistogram LocationErrorHistogram;
+        ThresholdHistogram IoUHistogram;
+
+        // curves from the histograms where each key is the threshold
         std::map<int, std::tuple<int, int>> DetectionMetrics;
         std::map<float, float> IoUMetrics;
-
-        FumaroleDetectionEvaluation();
     };
 
     /// Evaluation on multiple images (the entire detection algorithm)
@@ -44,12 +48,18 @@ namespace Evaluation
         int TotalNumberOfActualFumaroles = 0;
         int TotalNumberDetected = 0;
         float TotalAverageIoU = 0.0;
-        ConfusionMatrix ConfusionMatrix;
+        Evaluation::ConfusionMatrix ConfusionMatrix;
+
+        // histograms of all the detections (the sums of the histograms of the images) and their curves
+        ThresholdHistogram LocationErrorHistogram;
+        ThresholdHistogram IoUHistogram;
         std::map<int, std::tuple<int, int>> DetectionMetrics;
         std::map<float, float> IoUDetectionMetrics;
-        std::vector<FumaroleDetectionEvaluation> Evaluations;
 
-        AlgorithmEvaluation();
+        // one-to-one matching per class (precision recall curves and mAP)
+        MatchEvaluation Matching;
+
+        std::vector<FumaroleDetectionEvaluation> Evaluations;
     };
 }
 
@@ -0,0 +1,70 @@
+//
+// EvaluationAccumulator.hpp
+// Mergeable evaluation state of a set of images
+// Images can be evaluated independently (other threads or processes) and the accumulators merged in any order;
+// all the reductions are done when the evaluation is finalized, over the images in the order of their IDs,
+// so the result is the same as evaluating all the images one after another
+//
+
+#ifndef FUMAROLE_LOCALIZATION_EVALUATIONACCUMULATOR_HPP
+#define FUMAROLE_LOCALIZATION_EVALUATIONACCUMULATOR_HPP
+
+#include "detection/FumaroleDetection.hpp"
+#include "evaluation/Evaluation.hpp"
+#include "evaluation/MatchingEngine.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace Evaluation
+{
+    class EvaluationAccumulator
+    {
+    public:
+        /// Constructor
+        /// \param mode How the IoUs of the detections are computed for matching
+        explicit EvaluationAccumulator(IoUMode mode = IOU_BOX);
+
+        ~EvaluationAccumulator() = default;
+
+        /// Add the evaluation of an image
+        /// \param evaluation The evaluation of the image (with its image ID set)
+        /// \param results The detections of the image
+        /// \param truth The ground truth of the image
+        void AddImage(const FumaroleDetectionEvaluation& evaluation, const std::vector<Detection::FumaroleDetection>& results, const std::vector<Detection::FumaroleDetection>& truth);
+
+        /// Add an image with ground truth that has no detection results (only counted in the total number of actual fumaroles)
+        /// \param numberOfActualFumaroles The number of fumaroles in the ground truth of the image
+        void AddUnevaluatedImage(int numberOfActualFumaroles);
+
+        /// Add the images of another accumulator
+        /// \param other The other accumulator (its images must not be in this one)
+        /// \return Returns false if an image was in both (the image from the other accumulator is skipped)
+        bool Merge(const EvaluationAccumulator& other);
+
+        /// Compute the evaluation of all the images
+        /// \return The evaluation of the algorithm
+        AlgorithmEvaluation Finalize() const;
+
+        /// Save the accumulator (a shard of an evaluation) to a file
+        /// \param filePath The path of the file
+        /// \return Returns true on success
+        bool Save(const std::string& filePath) const;
+
+        /// Load an accumulator saved with Save (replacing the current state)
+        /// \param filePath The path of the file
+        /// \return Returns false if the file cannot be read or is corrupt (the current state is then kept)
+        bool Load(const std::string& filePath);
+
+    private:
+        int m_TotalNumberOfActualFumaroles = 0;
+
+        // evaluations of the single images ordered by image ID
+        std::map<std::string, FumaroleDetectionEvaluation> m_Evaluations;
+
+        MatchingEngine m_Matching;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_EVALUATIONACCUMULATOR_HPP
@@ -0,0 +1,179 @@
+//
+// MatchingEngine.hpp
+// One-to-one matching of detections to ground truth and COCO-style mean average precision
+// The IoU matrix is computed with the boxes stored as a structure of arrays so each row is a single vectorized (Eigen) expression
+//
+
+#ifndef FUMAROLE_LOCALIZATION_MATCHINGENGINE_HPP
+#define FUMAROLE_LOCALIZATION_MATCHINGENGINE_HPP
+
+#include "detection/FumaroleDetection.hpp"
+#include "model/FumaroleType.hpp"
+#include "evaluation/BitMask.hpp"
+
+#include <eigen3/Eigen/Eigen>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <map>
+
+namespace Evaluation
+{
+    // Row major so that the IoUs of a detection with all the ground truth are contiguous
+    typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> IoUMatrix;
+
+    // How detections are assigned to ground truth
+    enum AssignmentMethod {
+        ASSIGNMENT_GREEDY,
+        ASSIGNMENT_HUNGARIAN
+    };
+
+    // What the IoU of a detection and a ground truth fumarole is computed on
+    enum IoUMode {
+        IOU_BOX,
+        IOU_MASK
+    };
+
+    /// Bounding boxes as a structure of arrays (corners and areas)
+    struct BoxArray
+    {
+        Eigen::ArrayXf X1;
+        Eigen::ArrayXf Y1;
+        Eigen::ArrayXf X2;
+        Eigen::ArrayXf Y2;
+        Eigen::ArrayXf Area;
+
+        BoxArray() = default;
+
+        /// Construct from the bounding boxes of the detections
+        /// \param detections The detections
+        explicit BoxArray(const std::vector<Detection::FumaroleDetection>& detections);
+
+        /// Construct from the bounding boxes of some of the detections
+        /// \param detections The detections
+        /// \param indices The indices of the detections to use
+        BoxArray(const std::vector<Detection::FumaroleDetection>& detections, const std::vector<size_t>& indices);
+
+        Eigen::Index Size() const { return X1.size(); }
+    };
+
+    /// Precision recall curve of a class at a single IoU threshold
+    struct PrecisionRecallCurve
+    {
+        float IoUThreshold = 0.0;
+
+        // interpolated precision at the recall levels 0, 0.01, ..., 1
+        std::vector<float> Precision;
+
+        float AveragePrecision = 0.0;
+    };
+
+    /// Matching results of a single class
+    struct ClassMatchEvaluation
+    {
+        int NumberOfActualFumaroles = 0;
+        int NumberDetected = 0;
+
+        // one curve per IoU threshold
+        std::vector<PrecisionRecallCurve> Curves;
+
+        // average over the IoU thresholds
+        float AveragePrecision = 0.0;
+    };
+
+    /// Matching results over all classes
+    struct MatchEvaluation
+    {
+        // classes with no ground truth are not included
+        std::map<Model::FumaroleType, ClassMatchEvaluation> Classes;
+
+        // mean over the classes of the AP averaged over IoU 0.5:0.05:0.95, and at IoU 0.5 and 0.75
+        float MeanAveragePrecision = 0.0;
+        float MeanAveragePrecision50 = 0.0;
+        float MeanAveragePrecision75 = 0.0;
+    };
+
+    class MatchingEngine
+    {
+    public:
+        /// Constructor (IoU thresholds 0.5:0.05:0.95 and 101 recall levels as in COCO)
+        /// \param mode Whether the IoUs are computed on the bounding boxes or the masks of the contours
+        explicit MatchingEngine(IoUMode mode = IOU_BOX);
+
+        ~MatchingEngine() = default;
+
+        /// Match the detections of an image to its ground truth (per class, greedy by score at each IoU threshold) and accumulate the matches
+        /// \param results The detections of the image
+        /// \param truth The ground truth of the image
+        void AddImage(const std::vector<Detection::FumaroleDetection>& results, const std::vector<Detection::FumaroleDetection>& truth);
+
+        /// Compute the precision recall curves and mean average precision of all images added so far
+        /// The result does not depend on the order the images were added or merged in
+        /// \return The evaluation of the matches
+        MatchEvaluation Evaluate() const;
+
+        /// Add the matches of other images (e.g. evaluated by another thread or process)
+        /// \param other The engine with the matches of the other images
+        void Merge(const MatchingEngine& other);
+
+        /// Write the accumulated matches
+        /// \param os The output stream
+        void Write(std::ostream& os) const;
+
+        /// Read matches written by Write (replacing the current ones)
+        /// \param is The input stream
+        /// \return Returns false if the matches are truncated or corrupt (the current ones are then kept)
+        bool Read(std::istream& is);
+
+        /// Compute the IoU of every pair of boxes
+        /// \param a The boxes for the rows (detections)
+        /// \param b The boxes for the columns (ground truth)
+        /// \param iou Will be set to the (a.Size() x b.Size()) IoU matrix
+        static void ComputeIoUMatrix(const BoxArray& a, const BoxArray& b, IoUMatrix& iou);
+
+        /// Compute the mask IoU of every pair of masks
+        /// \param a The masks for the rows (detections)
+        /// \param b The masks for the columns (ground truth)
+        /// \param iou Will be set to the (a.size() x b.size()) IoU matrix
+        static void ComputeIoUMatrix(const std::vector<BitMask>& a, const std::vector<BitMask>& b, IoUMatrix& iou);
+
+        /// Compute the IoU of some of the detections with some of the ground truth
+        /// \param results The detections
+        /// \param resultIndices The indices of the detections for the rows
+        /// \param truth The ground truth
+        /// \param truthIndices The indices of the ground truth for the columns
+        /// \param mode Whether to compare the bounding boxes or the masks
+        /// \param iou Will be set to the IoU matrix
+        static void ComputeIoUMatrix(const std::vector<Detection::FumaroleDetection>& results, const std::vector<size_t>& resultIndices,
+                                     const std::vector<Detection::FumaroleDetection>& truth, const std::vector<size_t>& truthIndices,
+                                     IoUMode mode, IoUMatrix& iou);
+
+        /// Assign each row to at most one column in the order of decreasing score, each taking its best free column
+        /// \param iou The IoU matrix
+        /// \param scores The score of each row
+        /// \param threshold Pairs need at least this IoU (and more than 0) to be matched
+        /// \return The column assigned to each row or -1 if the row is not matched
+        static std::vector<int> GreedyAssignment(const IoUMatrix& iou, const std::vector<float>& scores, float threshold);
+
+        /// Assign rows to columns one-to-one so that the total IoU is maximal (Hungarian method)
+        /// \param iou The IoU matrix
+        /// \param threshold Assigned pairs with less IoU (or 0) are not matched
+        /// \return The column assigned to each row or -1 if the row is not matched
+        static std::vector<int> HungarianAssignment(const IoUMatrix& iou, float threshold);
+
+    private:
+        // a detection with its score and whether it was a true positive at each IoU threshold (bit i for threshold i)
+        struct MatchRecord
+        {
+            float Score;
+            uint32_t TruePositives;
+        };
+
+        IoUMode m_IoUMode;
+        std::vector<float> m_IoUThresholds;
+        std::map<Model::FumaroleType, std::vector<MatchRecord>> m_Records;
+        std::map<Model::FumaroleType, int> m_TruthCounts;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_MATCHINGENGINE_HPP
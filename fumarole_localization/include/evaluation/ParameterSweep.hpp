@@ -0,0 +1,85 @@
+//
+// ParameterSweep.hpp
+// Evaluates the detector over a grid of contour and classification params
+// The output of each pipeline stage is cached so that only the stages after a changed param are rerun
+//
+
+#ifndef FUMAROLE_LOCALIZATION_PARAMETERSWEEP_HPP
+#define FUMAROLE_LOCALIZATION_PARAMETERSWEEP_HPP
+
+#include "detection/FumaroleDetection.hpp"
+#include "evaluation/AlgorithmEvaluator.hpp"
+#include "pipeline/Pipeline.hpp"
+#include "config/DetectorConfig.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Evaluation
+{
+    /// A single point of the parameter grid
+    struct SweepParameters
+    {
+        float MinArea = 0.0;
+        float MinAreaHeatedArea = 0.0;
+        float OpenVentRadius = 0.0;
+        float HiddenVentRadius = 0.0;
+    };
+
+    /// The evaluation of the detector for a single point of the parameter grid
+    struct SweepResult
+    {
+        SweepParameters Parameters;
+        float AverageIoU = 0.0;
+        float ClassificationAccuracy = 0.0;
+        int TotalNumberDetected = 0;
+        int TotalNumberOfActualFumaroles = 0;
+    };
+
+    class ParameterSweep
+    {
+    public:
+        /// Constructor
+        /// \param files A map where key = the file id, and value = the file path to the thermal image
+        /// \param truth The ground truth for each file where <file id: ground truth detections>
+        /// \param config The config the grid points are applied to (the swept params are overridden for each grid point)
+        ParameterSweep(const std::map<std::string, std::string>& files, const std::map<std::string, std::vector<Detection::FumaroleDetection>>& truth, const Config::DetectorConfig& config);
+
+        ~ParameterSweep() = default;
+
+        /// Evaluate the detector on every combination of the given values (grid points are evaluated in parallel)
+        /// \param minAreas Values for the contour min area filter (config.pipeline.contour.min_area)
+        /// \param minAreasHeatedArea Values for config.detection.min_area_heated_area
+        /// \param openVentRadii Values for config.detection.open_vent_radius_search
+        /// \param hiddenVentRadii Values for config.detection.hidden_area_radius_search
+        /// \param results Will be set to the evaluation of each grid point
+        /// \return Returns true on success
+        bool Run(const std::vector<float>& minAreas, const std::vector<float>& minAreasHeatedArea, const std::vector<float>& openVentRadii, const std::vector<float>& hiddenVentRadii, std::vector<SweepResult>& results);
+
+        /// Save the sweep results to a CSV file
+        /// \param filePath The full path (including file extension) for the CSV file
+        /// \param results The evaluations of the grid points
+        static void SaveResultsToCSV(const std::string& filePath, const std::vector<SweepResult>& results);
+
+    private:
+        bool CacheContours();
+        void CacheLocalizations(const std::vector<float>& minAreas);
+        SweepResult EvaluateGridPoint(const SweepParameters& parameters) const;
+
+    private:
+        std::map<std::string, std::string> m_Files;
+        std::map<std::string, std::vector<Detection::FumaroleDetection>> m_Truth;
+        Config::DetectorConfig m_Config;
+        AlgorithmEvaluator m_Evaluator;
+
+        // stage 1: unfiltered contours of each image (the threshold stage does not depend on any swept param)
+        bool m_ContoursCached = false;
+        Pipeline::PipelineLocalizations m_Contours;
+
+        // stage 2: localizations of each image keyed by the contour min area
+        std::map<float, Pipeline::PipelineLocalizations> m_Localizations;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_PARAMETERSWEEP_HPP
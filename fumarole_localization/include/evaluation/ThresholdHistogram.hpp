@@ -0,0 +1,88 @@
+//
+// ThresholdHistogram.hpp
+// Integer counts of values in fixed threshold bins
+// A curve over the thresholds is computed with a single pass over the values (binning) and one over the bins (cumulative sums),
+// and the histograms of several images are added bin by bin
+//
+
+#ifndef FUMAROLE_LOCALIZATION_THRESHOLDHISTOGRAM_HPP
+#define FUMAROLE_LOCALIZATION_THRESHOLDHISTOGRAM_HPP
+
+#include <iostream>
+#include <vector>
+#include <tuple>
+#include <map>
+
+namespace Evaluation
+{
+    class ThresholdHistogram
+    {
+    public:
+        ThresholdHistogram() = default;
+
+        /// Construct an empty histogram
+        /// \param first The first threshold
+        /// \param step The step between two thresholds
+        /// \param thresholds The number of thresholds (bins)
+        ThresholdHistogram(float first, float step, int thresholds);
+
+        /// Count a value in the bin of the first threshold it is less than or equal to (values above the last threshold are counted as outside)
+        /// \param value The value (e.g. a location error)
+        void AddWithin(float value);
+
+        /// Count a value in the bin of the last threshold it is greater than or equal to (values below the first threshold are counted as outside)
+        /// \param value The value (e.g. an IoU)
+        void AddReaching(float value);
+
+        /// Get the threshold of a bin (computed from the bin index so equal bins of different histograms have equal thresholds)
+        /// \param bin The index of the bin
+        /// \return The threshold
+        float Threshold(int bin) const;
+
+        /// Returns the number of thresholds (bins)
+        int Thresholds() const;
+
+        /// Returns the number of values counted (including the ones outside the thresholds)
+        int Total() const;
+
+        /// Get the number of values in each bin or any bin before it
+        /// \return The cumulative counts per bin
+        std::vector<int> CumulativeUp() const;
+
+        /// Get the number of values in each bin or any bin after it
+        /// \return The cumulative counts per bin
+        std::vector<int> CumulativeDown() const;
+
+        /// Add the counts of another histogram
+        /// \param other The other histogram (an empty histogram takes the thresholds of the other, otherwise they must be the same)
+        /// \return Return the reference to this histogram
+        ThresholdHistogram& operator+=(const ThresholdHistogram& other);
+
+        /// Write the thresholds and counts
+        /// \param os The output stream
+        void Write(std::ostream& os) const;
+
+        /// Read a histogram written by Write
+        /// \param is The input stream
+        /// \return Returns false if the histogram is truncated or corrupt (e.g. more thresholds than a histogram can have)
+        bool Read(std::istream& is);
+
+    private:
+        float m_First = 0.0;
+        float m_Step = 1.0;
+        std::vector<int> m_Counts;
+        int m_Outside = 0;
+    };
+
+    /// Get the true and false positives at each location error threshold from the histogram of the errors (counted with AddWithin)
+    /// \param histogram The histogram of the distances of the detections to their nearest ground truth
+    /// \return A map with <threshold: (true positives, false positives)>
+    std::map<int, std::tuple<int, int>> DetectionCurve(const ThresholdHistogram& histogram);
+
+    /// Get the success rate at each IoU threshold from the histogram of the IoUs (counted with AddReaching)
+    /// \param histogram The histogram of the IoUs of the detections
+    /// \return A map with <threshold: rate of detections with at least the threshold IoU>
+    std::map<float, float> SuccessRateCurve(const ThresholdHistogram& histogram);
+}
+
+#endif //FUMAROLE_LOCALIZATION_THRESHOLDHISTOGRAM_HPP
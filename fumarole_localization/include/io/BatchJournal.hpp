@@ -0,0 +1,79 @@
+//
+// BatchJournal.hpp
+// Append-only journal of a batch run
+// Each completed image (with its detections) and each image that failed are appended (and synced to disk) as soon as
+// they are known, so a batch that is interrupted can be resumed from the journal without processing the completed images
+// again while still delivering their detections
+//
+
+#ifndef FUMAROLE_LOCALIZATION_BATCHJOURNAL_HPP
+#define FUMAROLE_LOCALIZATION_BATCHJOURNAL_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "detection/FumaroleDetection.hpp"
+
+namespace IO
+{
+    class BatchJournal
+    {
+    public:
+        /// Constructor
+        /// \param path The file path of the journal (created if it does not exist)
+        explicit BatchJournal(const std::string& path);
+
+        /// Destructor (closes the journal)
+        ~BatchJournal();
+
+        BatchJournal(const BatchJournal&) = delete;
+        BatchJournal& operator=(const BatchJournal&) = delete;
+
+        /// Read the records of a previous run and open the journal for appending
+        /// A record that was only partly written (the run was killed while writing it) is discarded, as is a completed record
+        /// without detections (written by an older version), so that image is processed again
+        /// \return Returns true on success
+        bool Open();
+
+        /// Get the images that were completed in previous runs
+        /// \return A map with <file id: detection record>
+        const std::map<std::string, std::string>& GetCompleted() const;
+
+        /// Read the detections of an image that was completed in a previous run (or this one)
+        /// \param fileID The ID of the image
+        /// \param detections Will be set to the detections of the image
+        /// \return Returns false if the image was not completed
+        bool ReadCompleted(const std::string& fileID, std::vector<Detection::FumaroleDetection>& detections) const;
+
+        /// Get the images that failed in previous runs
+        /// \return A map with <file id: reason>
+        const std::map<std::string, std::string>& GetFailed() const;
+
+        /// Returns true if the image was completed or failed in a previous run (or this one)
+        bool IsRecorded(const std::string& fileID) const;
+
+        /// Append a completed image with its detections (returns once it is synced to disk)
+        /// \param fileID The ID of the image
+        /// \param detections The detections of the image
+        /// \return Returns true on success
+        bool AppendCompleted(const std::string& fileID, const std::vector<Detection::FumaroleDetection>& detections);
+
+        /// Append an image that could not be processed (returns once it is synced to disk)
+        /// \param fileID The ID of the image
+        /// \param reason The reason why the image failed
+        /// \return Returns true on success
+        bool AppendFailed(const std::string& fileID, const std::string& reason);
+
+    private:
+        bool Append(const std::string& record);
+
+    private:
+        std::string m_Path;
+        int m_FileDescriptor = -1;
+        std::map<std::string, std::string> m_Completed;
+        std::map<std::string, std::string> m_Failed;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_BATCHJOURNAL_HPP
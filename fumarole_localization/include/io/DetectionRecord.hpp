@@ -0,0 +1,29 @@
+//
+// DetectionRecord.hpp
+// Text records of detections for the files written by the detector (result cache, journal)
+// A record is a single line of space separated values so a truncated record can be detected when reading
+//
+
+#ifndef FUMAROLE_LOCALIZATION_DETECTIONRECORD_HPP
+#define FUMAROLE_LOCALIZATION_DETECTIONRECORD_HPP
+
+#include <iostream>
+#include <vector>
+
+#include "detection/FumaroleDetection.hpp"
+
+namespace IO
+{
+    /// Write the detections of an image as one record (no line break is written)
+    /// \param os The output stream
+    /// \param detections The detections of the image
+    void WriteDetectionRecord(std::ostream& os, const std::vector<Detection::FumaroleDetection>& detections);
+
+    /// Read the detections of an image written by WriteDetectionRecord
+    /// \param is The input stream
+    /// \param detections Will be set to the detections of the image
+    /// \return Returns false if the record is truncated or corrupt
+    bool ReadDetectionRecord(std::istream& is, std::vector<Detection::FumaroleDetection>& detections);
+}
+
+#endif //FUMAROLE_LOCALIZATION_DETECTIONRECORD_HPP
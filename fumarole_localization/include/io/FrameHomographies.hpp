@@ -0,0 +1,27 @@
+//
+// FrameHomographies.hpp
+// Per-frame homographies from image pixels to world coordinates (e.g. from the survey pose of each frame)
+// The CSV file has one line per frame: file_id,h11,h12,h13,h21,h22,h23,h31,h32,h33 (row major)
+// A header line and lines starting with '#' are skipped
+//
+
+#ifndef FUMAROLE_LOCALIZATION_FRAMEHOMOGRAPHIES_HPP
+#define FUMAROLE_LOCALIZATION_FRAMEHOMOGRAPHIES_HPP
+
+#include <string>
+#include <unordered_map>
+#include <opencv2/core/core.hpp>
+
+namespace IO
+{
+    // Typedef for the homography of each frame where key: file id, value: pixel to world homography
+    typedef std::unordered_map<std::string, cv::Matx33d> FrameHomographies;
+
+    /// Load the homographies of the frames from a CSV file
+    /// \param filePath The path of the CSV file
+    /// \param homographies Will be set to the homography of each frame in the file
+    /// \return Returns false if the file could not be read or has a malformed line
+    bool LoadFrameHomographies(const std::string& filePath, FrameHomographies& homographies);
+}
+
+#endif //FUMAROLE_LOCALIZATION_FRAMEHOMOGRAPHIES_HPP
@@ -0,0 +1,54 @@
+//
+// ImageCache.hpp
+// In-memory cache of decoded (grayscale) thermal images shared by concurrent detection runs
+// Each image file is decoded once; a run that asks for an image another run is decoding waits for that decode instead of repeating it
+//
+
+#ifndef FUMAROLE_LOCALIZATION_IMAGECACHE_HPP
+#define FUMAROLE_LOCALIZATION_IMAGECACHE_HPP
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <opencv2/core/core.hpp>
+
+namespace IO
+{
+    class ImageCache
+    {
+    public:
+        /// Constructor
+        /// \param maxBytes The most bytes of decoded images kept (0 for no limit). Images decoded beyond that are not kept.
+        explicit ImageCache(size_t maxBytes = 0);
+
+        ~ImageCache() = default;
+
+        ImageCache(const ImageCache&) = delete;
+        ImageCache& operator=(const ImageCache&) = delete;
+
+        /// Get the decoded image of a file (thread safe)
+        /// The image is shared with the cache and other callers and must not be modified
+        /// \param path The file path of the image
+        /// \param image Will be set to the grayscale image
+        /// \return Returns false if the file could not be read (failed reads are not cached)
+        bool Load(const std::string& path, cv::Mat& image);
+
+        /// Returns the number of loads served without decoding
+        size_t GetHits() const;
+
+        /// Returns the number of images decoded
+        size_t GetMisses() const;
+
+    private:
+        std::mutex m_Mutex;
+        std::unordered_map<std::string, std::shared_future<cv::Mat>> m_Images;
+        size_t m_Bytes = 0;
+        size_t m_MaxBytes;
+        std::atomic<size_t> m_Hits { 0 };
+        std::atomic<size_t> m_Misses { 0 };
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_IMAGECACHE_HPP
@@ -0,0 +1,61 @@
+//
+// ResultCache.hpp
+// Persistent cache of the detections for each image
+// Entries are keyed by the hash of the image file content, the detection config and the detector version
+// so an image is only served from the cache if it would produce the same detections when run again
+//
+
+#ifndef FUMAROLE_LOCALIZATION_RESULTCACHE_HPP
+#define FUMAROLE_LOCALIZATION_RESULTCACHE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "detection/FumaroleDetection.hpp"
+
+namespace IO
+{
+    class ResultCache
+    {
+    public:
+        /// Constructor
+        /// \param directory The directory the cache entries are stored in (created if it does not exist)
+        /// \param configHash The hash of the effective detection config
+        ResultCache(const std::string& directory, uint64_t configHash);
+
+        ~ResultCache() = default;
+
+        /// Look up the detections for an image
+        /// \param imagePath The file path of the image (the content of the file is hashed)
+        /// \param key Will be set to the cache key of the image (used to store the detections on a miss)
+        /// \param detections Will be set to the cached detections on a hit
+        /// \return Returns true on a hit, false if the image has no entry or could not be read
+        bool Lookup(const std::string& imagePath, uint64_t& key, std::vector<Detection::FumaroleDetection>& detections) const;
+
+        /// Store the detections for an image
+        /// \param key The cache key of the image from Lookup
+        /// \param detections The detections of the image
+        /// \return Returns true on success
+        bool Store(uint64_t key, const std::vector<Detection::FumaroleDetection>& detections) const;
+
+        /// 64-bit FNV-1a hash
+        /// \param data The bytes to hash
+        /// \param size The number of bytes
+        /// \param hash The hash to continue from (to hash several buffers as one)
+        /// \return The hash
+        static uint64_t Hash(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS);
+
+    private:
+        std::string EntryPath(uint64_t key) const;
+
+    private:
+        static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+        static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+        std::string m_Directory;
+        uint64_t m_ConfigHash;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_RESULTCACHE_HPP
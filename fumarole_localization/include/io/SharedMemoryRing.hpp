@@ -0,0 +1,124 @@
+//
+// SharedMemoryRing.hpp
+// Single producer / single consumer ring of fixed size slots in POSIX shared memory
+// Frames are exchanged with other processes on the same machine without copying them through files or sockets:
+// the producer writes a slot in place and publishes it, the consumer reads it in place and releases it when done.
+// Head and tail are lock-free atomic counters in the shared memory (no locks, no system calls per slot).
+// Each ring is created by its producer and opened by its consumer.
+//
+
+#ifndef FUMAROLE_LOCALIZATION_SHAREDMEMORYRING_HPP
+#define FUMAROLE_LOCALIZATION_SHAREDMEMORYRING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace IO
+{
+    // Layout of a frame slot: the header followed by Height rows of Stride bytes (8-bit grayscale)
+    struct FrameSlot
+    {
+        uint64_t Sequence;
+        uint64_t Timestamp;
+        uint32_t Width;
+        uint32_t Height;
+        uint32_t Stride;
+        uint32_t Reserved;
+    };
+
+    // Status of the detection of a frame
+    enum ResultStatus {
+        RESULT_OK = 0,
+        RESULT_FAILED = 1,
+        RESULT_TRUNCATED = 2
+    };
+
+    // A detection in a result slot
+    struct ResultDetection
+    {
+        int32_t Type;
+        float Score;
+        int32_t X;
+        int32_t Y;
+        int32_t Width;
+        int32_t Height;
+    };
+
+    // The most detections a result slot holds (the rest are dropped and the status is RESULT_TRUNCATED)
+    const uint32_t MAX_RESULT_DETECTIONS { 64 };
+
+    // Layout of a result slot (the sequence and timestamp are those of the frame)
+    struct ResultSlot
+    {
+        uint64_t Sequence;
+        uint64_t Timestamp;
+        uint32_t Status;
+        uint32_t Count;
+        ResultDetection Detections[MAX_RESULT_DETECTIONS];
+    };
+
+    class SharedMemoryRing
+    {
+    public:
+        SharedMemoryRing() = default;
+
+        /// Destructor (unmaps the ring and removes it if it was created by this process)
+        ~SharedMemoryRing();
+
+        SharedMemoryRing(const SharedMemoryRing&) = delete;
+        SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+
+        /// Create the ring (as its producer), replacing a ring of the same name left by a previous run
+        /// \param name The name of the shared memory object (e.g. "/fumarole_frames")
+        /// \param slotCount The number of slots
+        /// \param slotSize The size of a slot in bytes
+        /// \return Returns false if the shared memory could not be created
+        bool Create(const std::string& name, uint32_t slotCount, uint32_t slotSize);
+
+        /// Open a ring created by another process (as its consumer)
+        /// \param name The name of the shared memory object
+        /// \return Returns false if the ring does not exist or has a different layout version
+        bool Open(const std::string& name);
+
+        /// Get the next free slot to write (producer only)
+        /// \return The slot or null if the ring is full
+        void* BeginWrite();
+
+        /// Publish the slot returned by BeginWrite to the consumer
+        void EndWrite();
+
+        /// Get the oldest published slot (consumer only)
+        /// \return The slot or null if the ring is empty. It stays valid until EndRead.
+        const void* BeginRead();
+
+        /// Release the slot returned by BeginRead back to the producer
+        void EndRead();
+
+        /// Returns the size of a slot in bytes
+        uint32_t GetSlotSize() const;
+
+        /// Returns the number of slots
+        uint32_t GetSlotCount() const;
+
+        /// Returns the number of published slots that were not released yet
+        uint64_t GetQueued() const;
+
+    private:
+        struct Header;
+
+        bool Map(int descriptor, size_t size);
+        void* Slot(uint64_t index) const;
+
+    private:
+        Header* m_Header = nullptr;
+        uint8_t* m_Slots = nullptr;
+        size_t m_MappedSize = 0;
+        size_t m_SlotStride = 0;
+        std::string m_Name;
+        bool m_Owner = false;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_SHAREDMEMORYRING_HPP
@@ -0,0 +1,96 @@
+//
+// FrameArena.hpp
+// Monotonic memory arena for all allocations made while processing a single frame
+// Everything allocated for a frame is released in one shot once the results of the frame are emitted
+//
+
+#ifndef FUMAROLE_LOCALIZATION_FRAMEARENA_HPP
+#define FUMAROLE_LOCALIZATION_FRAMEARENA_HPP
+
+#include <cstddef>
+#include <vector>
+#include <optional>
+#include <iostream>
+#include <memory_resource>
+
+namespace Memory
+{
+    /// Allocation counts of an arena
+    /// Only the allocations made through the arena's memory resource are counted. Memory allocated by OpenCV (e.g. the
+    /// buffers of findContours) and by the results that outlive a frame (e.g. the contours of the detections) comes
+    /// from the global heap and is not part of these counts.
+    struct AllocationStats
+    {
+        // number of calls to Release: the pipeline releases the arena after each frame and the classification after each
+        // image it classified, so a detector that shares one arena between both counts two releases per processed image
+        size_t Releases = 0;
+
+        // allocations served by the arena
+        size_t ArenaAllocations = 0;
+        size_t ArenaBytes = 0;
+
+        // allocations the arena had to make from the heap because its buffer overflowed
+        size_t HeapAllocations = 0;
+        size_t HeapBytes = 0;
+
+        // current size of the arena's buffer
+        size_t BufferSize = 0;
+
+        AllocationStats& operator+=(const AllocationStats& other);
+
+        friend std::ostream& operator<<(std::ostream& os, const AllocationStats& stats);
+    };
+
+    /// Memory resource that counts the allocations it passes on to its upstream resource
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+        explicit CountingResource(std::pmr::memory_resource* upstream);
+
+        void SetUpstream(std::pmr::memory_resource* upstream) { m_Upstream = upstream; }
+
+        size_t Allocations() const { return m_Allocations; }
+        size_t Bytes() const { return m_Bytes; }
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    private:
+        std::pmr::memory_resource* m_Upstream;
+        size_t m_Allocations = 0;
+        size_t m_Bytes = 0;
+    };
+
+    class FrameArena
+    {
+    public:
+        /// Constructor
+        /// \param initialSize The initial size of the arena's buffer in bytes (grows if a frame needs more)
+        explicit FrameArena(size_t initialSize = 1 << 20);
+
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        /// Get the memory resource to allocate per-frame data from
+        /// \return The resource (stable for the lifetime of the arena)
+        std::pmr::memory_resource* Resource();
+
+        /// Release everything allocated for the current frame
+        /// All objects allocated from the resource must be destroyed before calling this
+        void Release();
+
+        /// Get the allocation counts of all frames released so far
+        const AllocationStats& Stats() const;
+
+    private:
+        std::vector<std::byte> m_Buffer;
+        CountingResource m_Heap;
+        std::optional<std::pmr::monotonic_buffer_resource> m_Arena;
+        CountingResource m_Resource;
+        AllocationStats m_Stats;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_FRAMEARENA_HPP
@@ -12,10 +12,6 @@
 
 namespace Model
 {
-    static std::vector<std::string> ClassLabels = {
-        "fumarole_hole", "fumarole_open_vent", "fumarole_heated_area", "fumarole_hidden_vent"
-    };
-
     enum FumaroleType {
         FUMAROLE_HOLE,
         FUMAROLE_OPEN_VENT,
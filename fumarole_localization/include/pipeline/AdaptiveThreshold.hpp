@@ -0,0 +1,52 @@
+//
+// AdaptiveThreshold.hpp
+// Performs a locally adaptive threshold for hot areas
+// A pixel is kept in a heat range channel only if it is above the range's lower bound
+// and either above the local threshold (mean + k * std dev) of its neighbourhood window or the window mean is above the
+// lower bound too. Inside a hot area larger than the window there is no local contrast (value ~ mean, std dev ~ 0), so
+// such pixels are kept as with the plain heat threshold instead of leaving only the rim of the area.
+// Outputs the thresholded images in N channels (same layout as HeatThreshold)
+//
+
+#ifndef FUMAROLE_LOCALIZATION_ADAPTIVETHRESHOLD_HPP
+#define FUMAROLE_LOCALIZATION_ADAPTIVETHRESHOLD_HPP
+
+#include "pipeline/PipelineElement.hpp"
+#include "config/DetectorConfig.hpp"
+
+#include <vector>
+#include <memory>
+
+namespace Pipeline
+{
+    class AdaptiveThreshold : public PipelineElement
+    {
+    public:
+        AdaptiveThreshold(const std::string& name, bool saveResults, const Config::PipelineConfig& config);
+        ~AdaptiveThreshold() = default;
+
+        /// Applies N threshold ranges (defined in the config file) relative to the local neighbourhood of each pixel
+        /// \param input The input to the threshold (greyscale image)
+        /// \param output Will be a thresholded N-channel image
+        /// \param previousElementResult A reference to the previous pipeline's result (expected to be null)
+        /// \param result Not used
+        /// \param filename The name of the file being processed
+        void Process(const cv::Mat& input, cv::Mat& output, const std::shared_ptr<void>& previousElementResult, std::shared_ptr<void>& result, const std::string& filename = "") override;
+
+    private:
+        void ComputeIntegralImages(const cv::Mat& input);
+        void ThresholdRows(const cv::Mat& input, cv::Mat& output, int rowStart, int rowEnd) const;
+
+    private:
+        std::vector<int> m_HeatRanges;
+        int m_WindowRadius;
+        float m_K;
+
+        // integral images of the border-padded input (reused between images of the same size)
+        cv::Mat m_Padded;
+        cv::Mat m_Sum;
+        cv::Mat m_SquaredSum;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_ADAPTIVETHRESHOLD_HPP
@@ -0,0 +1,30 @@
+//
+// ContourFeatures.hpp
+// Geometry and intensity features of a contour
+// Computed once when the contour is found and read by the later stages instead of recomputing them
+//
+
+#ifndef FUMAROLE_LOCALIZATION_CONTOURFEATURES_HPP
+#define FUMAROLE_LOCALIZATION_CONTOURFEATURES_HPP
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/core/types.hpp>
+
+namespace Pipeline
+{
+    struct ContourFeatures
+    {
+        double Area = 0.0;
+        double Perimeter = 0.0;
+        cv::Rect BoundingBox;
+        cv::Point2f Centroid;
+
+        // index of the heat range (channel) the contour was found in
+        int Band = 0;
+
+        // max intensity of the thermal image inside the contour
+        int PeakIntensity = 0;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_CONTOURFEATURES_HPP
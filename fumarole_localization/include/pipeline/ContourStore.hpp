@@ -0,0 +1,133 @@
+//
+// ContourStore.hpp
+// Flat storage for a set of contours
+// All points are kept in one contiguous array with offset / length / band arrays indexing into it (CSR layout)
+//
+
+#ifndef FUMAROLE_LOCALIZATION_CONTOURSTORE_HPP
+#define FUMAROLE_LOCALIZATION_CONTOURSTORE_HPP
+
+#include "pipeline/ContourFeatures.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <memory_resource>
+#include <opencv2/core/core.hpp>
+#include <opencv2/core/types.hpp>
+
+namespace Pipeline
+{
+    class ContourStore
+    {
+    public:
+        /// Constructor
+        /// \param resource The memory resource to allocate the arrays from (e.g. a frame arena)
+        explicit ContourStore(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        ~ContourStore() = default;
+
+        /// Get the number of contours in the store
+        /// \return The number of contours
+        size_t Size() const { return m_Offsets.size(); }
+
+        /// Returns true if there are no contours in the store
+        bool Empty() const { return m_Offsets.empty(); }
+
+        /// Get the total number of points of all contours
+        size_t PointCount() const { return m_Points.size(); }
+
+        /// Append a contour
+        /// \param points Pointer to the first point of the contour
+        /// \param count The number of points in the contour
+        /// \param features The features of the contour (the band is taken from the features)
+        void Add(const cv::Point* points, int count, const ContourFeatures& features);
+
+        /// Append a contour
+        /// \param points The points of the contour
+        /// \param features The features of the contour (the band is taken from the features)
+        void Add(const std::vector<cv::Point>& points, const ContourFeatures& features);
+
+        /// Append a contour from another store
+        /// \param other The other store
+        /// \param index The index of the contour in the other store
+        void Append(const ContourStore& other, size_t index);
+
+        /// Append all contours from another store, translating them by the given offset
+        /// \param other The other store
+        /// \param offset The offset added to the points, bounding boxes and centroids
+        void Append(const ContourStore& other, const cv::Point& offset);
+
+        /// Get a pointer to the first point of a contour
+        const cv::Point* Points(size_t index) const { return m_Points.data() + m_Offsets[index]; }
+
+        /// Get the number of points of a contour
+        int Length(size_t index) const { return m_Lengths[index]; }
+
+        /// Get the band (heat range index) of a contour
+        int Band(size_t index) const { return m_Bands[index]; }
+
+        /// Get the features of a contour
+        const ContourFeatures& Features(size_t index) const { return m_Features[index]; }
+        ContourFeatures& Features(size_t index) { return m_Features[index]; }
+
+        /// Get a (N x 1, CV_32SC2) matrix header over the points of a contour for OpenCV functions (no copy)
+        /// \param index The index of the contour
+        /// \return The matrix header (only valid until the store is modified)
+        cv::Mat PointsMat(size_t index) const;
+
+        /// Copy the points of a contour into a vector
+        /// \param index The index of the contour
+        /// \return A copy of the points
+        std::vector<cv::Point> CopyPoints(size_t index) const;
+
+        /// Remove all contours
+        void Clear();
+
+        /// Reserve memory for the given number of contours and points
+        void Reserve(size_t contours, size_t points);
+
+        /// Remove the contours for which the predicate returns true by compacting the store in place
+        /// \param predicate Called with the features of each contour
+        template <class Predicate>
+        void RemoveIf(Predicate predicate)
+        {
+            size_t kept = 0;
+            int pointOffset = 0;
+
+            for (size_t i = 0; i < Size(); i++)
+            {
+                if (predicate(m_Features[i])) {
+                    continue;
+                }
+
+                // move the points down into the gap (destination is always before the source)
+                if (pointOffset != m_Offsets[i]) {
+                    std::copy(m_Points.begin() + m_Offsets[i], m_Points.begin() + m_Offsets[i] + m_Lengths[i], m_Points.begin() + pointOffset);
+                }
+
+                m_Offsets[kept] = pointOffset;
+                m_Lengths[kept] = m_Lengths[i];
+                m_Bands[kept] = m_Bands[i];
+                m_Features[kept] = m_Features[i];
+
+                pointOffset += m_Lengths[i];
+                kept++;
+            }
+
+            m_Points.resize(pointOffset);
+            m_Offsets.resize(kept);
+            m_Lengths.resize(kept);
+            m_Bands.resize(kept);
+            m_Features.resize(kept);
+        }
+
+    private:
+        std::pmr::vector<cv::Point> m_Points;
+        std::pmr::vector<int> m_Offsets;
+        std::pmr::vector<int> m_Lengths;
+        std::pmr::vector<int> m_Bands;
+        std::pmr::vector<ContourFeatures> m_Features;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_CONTOURSTORE_HPP
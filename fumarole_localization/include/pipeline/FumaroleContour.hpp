@@ -9,6 +9,7 @@
 
 #include "pipeline/Typedefs.hpp"
 #include "pipeline/PipelineElement.hpp"
+#include "config/DetectorConfig.hpp"
 
 #include <opencv2/core/core.hpp>
 #include <vector>
@@ -22,7 +23,8 @@ namespace Pipeline
     public:
         /// Constructor
         /// \param name The name of this contour pipeline processing element
-        FumaroleContour(const std::string& name, bool saveResults);
+        /// \param config The pipeline config (for the min area filter)
+        FumaroleContour(const std::string& name, bool saveResults, const Config::PipelineConfig& config);
 
         /// Destructor
         ~FumaroleContour();
@@ -34,12 +36,17 @@ namespace Pipeline
         void Process(const cv::Mat& input, cv::Mat& output, const std::shared_ptr<void>& previousElementResult, std::shared_ptr<void>& result, const std::string& filename = "") override;
 
     private:
-        void FilterContourNoise(std::vector<std::vector<cv::Point>>& contours) const;
-        std::vector<std::vector<cv::Point>> FindContours(const cv::Mat& image) const;
-        void SaveContourResults(const FumaroleContours& contours, const std::string& filename) const;
+        void FindContours(const cv::Mat& image, int band, FumaroleContours& contours);
+        void ComputeFeatures(const cv::Mat& image, FumaroleContours& contours, size_t index) const;
+        void SaveContourResults(const FumaroleContours& contours, int bands, const std::string& filename) const;
 
     private:
         float m_MinAreaFilter;
+
+        // reused between images for the split channels and the output of cv::findContours
+        std::vector<cv::Mat> m_Channels;
+        std::vector<std::vector<cv::Point>> m_FoundContours;
+        std::vector<cv::Vec4i> m_Hierarchy;
     };
 }
 
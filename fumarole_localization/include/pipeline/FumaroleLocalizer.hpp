@@ -7,6 +7,7 @@
 #define FUMAROLE_LOCALIZATION_FUMAROLELOCALIZER_HPP
 
 #include "PipelineElement.hpp"
+#include "pipeline/Typedefs.hpp"
 
 #include <string>
 
@@ -32,8 +33,8 @@ namespace Pipeline
         void Process(const cv::Mat& input, cv::Mat& output, const std::shared_ptr<void>& previousElementResult, std::shared_ptr<void>& result, const std::string& filename = "") override;
 
     private:
-        bool IsContourEnclosingContour(const std::vector<cv::Point>& inner, const std::vector<cv::Point>& outer) const;
-        bool IsContourEnclosingSomeContour(const std::vector<cv::Point>& contour, std::vector<std::vector<cv::Point>>& contours) const;
+        bool IsContourEnclosingContour(const ContourFeatures& outer, const ContourFeatures& inner) const;
+        bool IsContourEnclosingSomeContour(const ContourFeatures& contour, const FumaroleContours& contours) const;
     };
 }
 
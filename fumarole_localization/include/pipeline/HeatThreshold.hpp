@@ -8,6 +8,7 @@
 #define FUMAROLE_LOCALIZATION_HEATTHRESHOLD_HPP
 
 #include "pipeline/PipelineElement.hpp"
+#include "config/DetectorConfig.hpp"
 
 #include <vector>
 #include <memory>
@@ -17,7 +18,7 @@ namespace Pipeline
     class HeatThreshold : public PipelineElement
     {
     public:
-        HeatThreshold(const std::string &name, bool saveResults);
+        HeatThreshold(const std::string &name, bool saveResults, const Config::PipelineConfig& config);
         ~HeatThreshold() = default;
 
         /// Applies N threshold ranges (defined in the config file), and saves it in separate channels of the output image
@@ -29,10 +30,11 @@ namespace Pipeline
         void Process(const cv::Mat& input, cv::Mat& output, const std::shared_ptr<void>& previousElementResult, std::shared_ptr<void>& result, const std::string& filename = "") override;
 
     private:
-        void ThresholdImage(const cv::Mat& input, cv::Mat& output, int channel, int lower, int upper);
+        void ThresholdImage(const cv::Mat& input, cv::Mat& output) const;
 
     private:
         std::vector<int> m_HeatRanges;
+        cv::Mat m_Thresholds;
     };
 }
 
@@ -13,6 +13,7 @@
 #include <map>
 
 #include "pipeline/PipelineElement.hpp"
+#include "config/DetectorConfig.hpp"
 
 namespace Pipeline
 {
@@ -21,7 +22,8 @@ namespace Pipeline
     public:
         /// Constructor
         /// \param name The name of the pipeline element
-        HistogramAnalysis(const std::string& name, bool saveResults);
+        /// \param config The pipeline config (for the heat bins)
+        HistogramAnalysis(const std::string& name, bool saveResults, const Config::PipelineConfig& config);
 
         ~HistogramAnalysis();
 
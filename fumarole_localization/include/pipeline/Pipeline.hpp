@@ -10,39 +10,117 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <functional>
 
 #include "pipeline/PipelineElement.hpp"
+#include "pipeline/ContourStore.hpp"
 #include "model/FumaroleType.hpp"
+#include "memory/FrameArena.hpp"
+#include "config/DetectorConfig.hpp"
 
 namespace Pipeline
 {
     // Typedef for the final localization result
-    typedef std::map<std::string, std::vector<std::vector<cv::Point>>> PipelineLocalizations;
+    typedef std::map<std::string, ContourStore> PipelineLocalizations;
+
+    // Called with the localizations of each image as soon as the image is processed
+    typedef std::function<void(const std::string& fileID, const ContourStore& localizations)> LocalizationCallback;
+
+    // Called with the reason when an image could not be processed
+    typedef std::function<void(const std::string& fileID, const std::string& reason)> FailureCallback;
+
+    // Reads the (grayscale) image of a file, returns false if it could not be read
+    typedef std::function<bool(const std::string& path, cv::Mat& image)> ImageLoader;
+
+    // The last stage the pipeline runs for each image
+    enum PipelineStage {
+        PIPELINE_STAGE_CONTOURS,
+        PIPELINE_STAGE_LOCALIZATIONS
+    };
 
     class Pipeline
     {
     public:
         /// Create the default pipeline for this processing task
         /// \param files A map with the key as the file id (name) and the value the file path
+        /// \param config The params of the pipeline elements (only used while constructing)
         /// \param saveResults Pass true if pipeline elements are required to save intermediate results as images
+        /// \param arena The arena to allocate per-frame data from (released after each frame). The pipeline creates its own if null.
+        /// \param lastStage The stage whose contours are kept for each image. Stopping at the contours skips the localizer.
         /// \return An instance of a pipeline with the given pipeline elements
-        Pipeline(const std::map<std::string, std::string>& files, bool saveResults);
+        Pipeline(const std::map<std::string, std::string>& files, const Config::PipelineConfig& config, bool saveResults, Memory::FrameArena* arena = nullptr, PipelineStage lastStage = PIPELINE_STAGE_LOCALIZATIONS);
 
         /// Destructor
         ~Pipeline();
 
         /// Run the pipeline with the configured elements
+        /// An image that fails (unreadable file or an error while processing it) is recorded and the other images are still processed
+        /// \return Returns true when all images were attempted (see GetFailures for the images that failed), false if it was stopped
         bool Run();
 
+        /// Stop a run after the current image (e.g. from a callback that cannot record its result), the other images are not processed
+        void Stop();
+
+        /// Run the pipeline on a decoded frame that is already in memory (the files of the pipeline are not used)
+        /// Everything allocated from the frame arena is released before returning
+        /// \param image The 8-bit grayscale thermal frame (only read)
+        /// \param fileID The ID of the frame (used to name saved intermediate results)
+        /// \param contours Will be set to the localizations (or contours) of the frame
+        void ProcessFrame(const cv::Mat& image, const std::string& fileID, ContourStore& contours);
+
+        /// Set a callback that is called for each image as soon as it is processed
+        /// The localizations are then not kept by the pipeline (GetLocalizations only has the images processed without a callback)
+        /// \param callback The callback. If it throws, the image is recorded as failed.
+        void SetLocalizationCallback(LocalizationCallback callback);
+
+        /// Set a callback that is called for each image that fails
+        /// \param callback The callback
+        void SetFailureCallback(FailureCallback callback);
+
+        /// Set the function that reads the images (e.g. from a cache of decoded images) instead of decoding each file
+        /// \param loader The image loader. The image it gives is only read, never modified.
+        void SetImageLoader(ImageLoader loader);
+
+        /// Get the images that could not be processed
+        /// \return A map with the key as the file id and the value the reason it failed
+        const std::map<std::string, std::string>& GetFailures() const;
+
         /// Get the final, processed localizations for each image that was run through this pipeline
-        /// \return A copy of the processed localizations. The key in the map is the fileID, and the value is a list of contours.
-        PipelineLocalizations GetLocalizations() const;
+        /// \return A reference to the processed localizations. The key in the map is the fileID, and the value is a list of contours (with their features).
+        /// If the pipeline stops at the contours stage these are the (filtered) contours of all bands instead.
+        const PipelineLocalizations& GetLocalizations() const;
+
+        /// Get the number of frames that were skipped because no pixel was above the lowest heat range
+        /// \return The number of skipped (cold) frames
+        int GetSkippedFrameCount() const;
+
+        /// Get the allocation counts of the per-frame arena
+        /// \return The allocation stats of the arena
+        const Memory::AllocationStats& GetAllocationStats() const;
+
+    private:
+        void RunOnFile(const std::string& fileID, const std::string& path, cv::Mat& input, ContourStore& contours);
+        void RecordFailure(const std::string& fileID, const std::string& reason);
+        bool IsColdFrame(const cv::Mat& image) const;
+        void RunOnFrame(const cv::Mat& image, const std::string& fileID, ContourStore& contours);
+        void RunOnRegions(const cv::Mat& image, const std::string& fileID, ContourStore& contours);
 
     private:
         std::map<std::string, std::string> m_Files;
         std::vector<std::unique_ptr<PipelineElement>> m_Elements;
+        std::unique_ptr<PipelineElement> m_RegionProposal;
         PipelineLocalizations m_Localizations;
+        std::map<std::string, std::string> m_Failures;
+        LocalizationCallback m_LocalizationCallback;
+        FailureCallback m_FailureCallback;
+        ImageLoader m_ImageLoader;
+        std::unique_ptr<Memory::FrameArena> m_OwnedArena;
+        Memory::FrameArena* m_Arena;
         bool m_SaveResults;
+        PipelineStage m_LastStage;
+        int m_LowestHeatRange;
+        int m_SkippedFrames = 0;
+        bool m_Stopped = false;
     };
 }
 
@@ -9,6 +9,7 @@
 #include <opencv2/core.hpp>
 #include <string>
 #include <memory>
+#include <memory_resource>
 
 namespace Pipeline
 {
@@ -29,6 +30,10 @@ namespace Pipeline
         /// Note: filename should not include the file extension
         virtual void Process(const cv::Mat& input, cv::Mat& output, const std::shared_ptr<void>& previousElementResult, std::shared_ptr<void>& result, const std::string& filename = "") = 0;
 
+        /// Set the memory resource that per-frame results are allocated from
+        /// \param resource The resource (usually the frame arena of the pipeline)
+        void SetMemoryResource(std::pmr::memory_resource* resource);
+
     protected:
         void SaveResult(const cv::Mat& output, const std::string& filename) const;
 
@@ -36,6 +41,7 @@ namespace Pipeline
         std::string m_Name;
         bool m_SaveIntermediateResults;
         std::shared_ptr<void> m_PreviousElementResult;
+        std::pmr::memory_resource* m_MemoryResource = std::pmr::get_default_resource();
     };
 }
 
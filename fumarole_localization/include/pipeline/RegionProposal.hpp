@@ -0,0 +1,49 @@
+//
+// RegionProposal.hpp
+// Proposes candidate regions of interest for fumaroles on a downsampled pyramid level
+// The pyramid is built with max pooling so that small hot areas are never averaged away
+// Outputs the regions (padded, merged, in full resolution frame coordinates) as the result
+//
+
+#ifndef FUMAROLE_LOCALIZATION_REGIONPROPOSAL_HPP
+#define FUMAROLE_LOCALIZATION_REGIONPROPOSAL_HPP
+
+#include "pipeline/PipelineElement.hpp"
+#include "config/DetectorConfig.hpp"
+
+#include <vector>
+#include <memory>
+#include <memory_resource>
+#include <opencv2/core/types.hpp>
+
+namespace Pipeline
+{
+    class RegionProposal : public PipelineElement
+    {
+    public:
+        RegionProposal(const std::string& name, bool saveResults, const Config::PipelineConfig& config);
+        ~RegionProposal() = default;
+
+        /// Find the candidate regions of the thermal image that are above the lowest heat range
+        /// \param input The full resolution greyscale thermal image
+        /// \param output Will be set to the input (this element does not produce any new output)
+        /// \param previousElementResult Not used
+        /// \param result Will be set to a std::pmr::vector<cv::Rect> of regions in full resolution frame coordinates
+        /// \param filename The name of the file being processed
+        void Process(const cv::Mat& input, cv::Mat& output, const std::shared_ptr<void>& previousElementResult, std::shared_ptr<void>& result, const std::string& filename = "") override;
+
+    private:
+        void MaxPoolDown(const cv::Mat& input, cv::Mat& output) const;
+        void MergeOverlappingRegions(std::pmr::vector<cv::Rect>& regions) const;
+
+    private:
+        int m_Levels;
+        int m_Padding;
+        int m_LowestHeatRange;
+
+        // reused between images for the output of cv::findContours
+        std::vector<std::vector<cv::Point>> m_FoundContours;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_REGIONPROPOSAL_HPP
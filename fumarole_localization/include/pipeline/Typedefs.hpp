@@ -10,9 +10,9 @@
 #include <vector>
 #include <opencv2/core/core.hpp>
 
-// A vector where each element is:
-//  a vector where each element is (a vector of contours):
-//      a vector of points (a contour)
-typedef std::vector<std::vector<std::vector<cv::Point>>> FumaroleContours;
+#include "pipeline/ContourStore.hpp"
+
+// The contours of all heat ranges in one flat store (the band of each contour is the heat range it was found in)
+typedef Pipeline::ContourStore FumaroleContours;
 
 #endif //FUMAROLE_LOCALIZATION_TYPEDEFS_HPP
@@ -0,0 +1,172 @@
+//
+// DetectionServer.hpp
+// Long-running detection service on a Unix domain socket (local clients only)
+// Saves the process start, config load and directory scan of running the detector once per request
+//
+// Protocol (native byte order, clients run on the same host):
+//   request: uint32 type, uint32 payload size, payload
+//     REQUEST_PATH   payload is the path of a thermal image file
+//     REQUEST_FRAME  payload is uint32 width, uint32 height, then width * height 8-bit grayscale pixels (rows not padded)
+//                    (at most config.server.max_frame_bytes pixels)
+//     REQUEST_STATS  no payload
+//   reply: uint32 size, then that many bytes of JSON
+//     {"status":"ok","detections":[{"type":"...","score":0.9,"x":1,"y":2,"width":3,"height":4},...]}
+//     {"status":"error","message":"..."}
+// A connection can send any number of requests; each is answered before the next is read
+// At most config.server.max_connections connections are served at once, more get an error reply and are closed
+//
+
+#ifndef FUMAROLE_LOCALIZATION_DETECTIONSERVER_HPP
+#define FUMAROLE_LOCALIZATION_DETECTIONSERVER_HPP
+
+#include "detection/FumaroleDetection.hpp"
+#include "config/DetectorConfig.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+namespace Server
+{
+    // Type of a request
+    enum RequestType {
+        REQUEST_PATH = 1,
+        REQUEST_FRAME = 2,
+        REQUEST_STATS = 3
+    };
+
+    /// Counters of the server since it was started
+    struct ServerStats
+    {
+        uint64_t Requests = 0;
+        uint64_t Frames = 0;
+        uint64_t Failures = 0;
+        uint64_t Batches = 0;
+        uint64_t RefusedConnections = 0;
+        size_t QueueDepth = 0;
+        size_t MaxQueueDepth = 0;
+        size_t Connections = 0;
+        double UptimeSeconds = 0.0;
+
+        /// Frames detected per second since the server was started
+        double FramesPerSecond() const { return (UptimeSeconds > 0.0 ? static_cast<double>(Frames) / UptimeSeconds : 0.0); }
+
+        /// Average number of frames detected per batch of a worker
+        double AverageBatchSize() const { return (Batches > 0 ? static_cast<double>(Frames + Failures) / static_cast<double>(Batches) : 0.0); }
+
+        /// Output the stats as readable text
+        /// \param os output stream
+        /// \param stats The server stats
+        /// \return A reference to the output stream
+        friend std::ostream& operator<<(std::ostream& os, const ServerStats& stats)
+        {
+            os << "\n--------------- Server Stats ---------------";
+            os << "\nRequests = " << stats.Requests;
+            os << "\nFrames detected = " << stats.Frames;
+            os << "\nFailed frames = " << stats.Failures;
+            os << "\nFrames per second = " << stats.FramesPerSecond();
+            os << "\nAverage batch size = " << stats.AverageBatchSize();
+            os << "\nQueue depth = " << stats.QueueDepth << " (max " << stats.MaxQueueDepth << ")";
+            os << "\nOpen connections = " << stats.Connections;
+            os << "\nRefused connections = " << stats.RefusedConnections;
+            os << std::endl;
+
+            return os;
+        }
+    };
+
+    class DetectionServer
+    {
+    public:
+        /// Constructor
+        /// \param config The params of the detector and of the server (copied). Each worker thread has its own detector session,
+        /// a worker takes at most the max batch size of queued requests at once (only reached while all workers are busy).
+        /// \param socketPath The file path of the Unix domain socket (replaced if it exists)
+        DetectionServer(const Config::DetectorConfig& config, std::string socketPath);
+
+        /// Destructor (stops the server)
+        ~DetectionServer();
+
+        DetectionServer(const DetectionServer&) = delete;
+        DetectionServer& operator=(const DetectionServer&) = delete;
+
+        /// Bind the socket and start the workers
+        /// \return Returns false if the socket could not be created
+        bool Start();
+
+        /// Accept connections until Stop is called (Start must have succeeded)
+        void Run();
+
+        /// Stop accepting connections and let Run return (safe to call from a signal handler)
+        void Stop();
+
+        /// Get the counters of the server
+        ServerStats GetStats() const;
+
+    private:
+        struct Job
+        {
+            RequestType Type;
+            std::string Path;
+            cv::Mat Frame;
+            std::promise<std::string> Reply;
+        };
+
+        struct Connection
+        {
+            int Socket = -1;
+            std::thread Thread;
+            std::atomic<bool> Done { false };
+        };
+
+        void Serve(Connection& connection);
+        bool ReadRequest(int socket, std::unique_ptr<Job>& job, std::string& error) const;
+        std::string Submit(std::unique_ptr<Job> job);
+        void RunWorker();
+        void CloseConnections(bool finishedOnly);
+        void Shutdown();
+
+        static std::string DetectionsReply(const std::vector<Detection::FumaroleDetection>& detections);
+        static std::string ErrorReply(const std::string& message);
+        static std::string StatsReply(const ServerStats& stats);
+
+    private:
+        Config::DetectorConfig m_Config;
+        std::string m_SocketPath;
+        int m_ListenSocket = -1;
+        std::atomic<bool> m_Stopping { false };
+        std::chrono::steady_clock::time_point m_StartTime;
+
+        // requests waiting for a worker
+        mutable std::mutex m_QueueMutex;
+        std::condition_variable m_QueueCondition;
+        std::deque<std::unique_ptr<Job>> m_Queue;
+        bool m_WorkersStopping = false;
+        int m_IdleWorkers = 0;
+        std::vector<std::thread> m_Workers;
+
+        mutable std::mutex m_ConnectionsMutex;
+        std::list<std::unique_ptr<Connection>> m_Connections;
+
+        // counters (the queue depths are guarded by the queue mutex)
+        std::atomic<uint64_t> m_Requests { 0 };
+        std::atomic<uint64_t> m_Frames { 0 };
+        std::atomic<uint64_t> m_Failures { 0 };
+        std::atomic<uint64_t> m_Batches { 0 };
+        std::atomic<uint64_t> m_RefusedConnections { 0 };
+        size_t m_MaxQueueDepth = 0;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_DETECTIONSERVER_HPP
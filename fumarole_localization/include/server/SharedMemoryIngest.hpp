@@ -0,0 +1,89 @@
+//
+// SharedMemoryIngest.hpp
+// Detects the frames a capture process writes into a shared memory frame ring and writes the detections into a result ring
+// Frames are detected in place in the shared memory and their slot is only released once the result is published,
+// so a slow detector makes the capture process wait (or drop frames) instead of buffering copies
+//
+
+#ifndef FUMAROLE_LOCALIZATION_SHAREDMEMORYINGEST_HPP
+#define FUMAROLE_LOCALIZATION_SHAREDMEMORYINGEST_HPP
+
+#include "detection/DetectorSession.hpp"
+#include "io/SharedMemoryRing.hpp"
+#include "config/DetectorConfig.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace Server
+{
+    /// Counters of the shared memory ingestion
+    struct IngestStats
+    {
+        uint64_t Frames = 0;
+        uint64_t Failures = 0;
+        uint64_t TruncatedResults = 0;
+
+        /// Output the stats as readable text
+        /// \param os output stream
+        /// \param stats The ingest stats
+        /// \return A reference to the output stream
+        friend std::ostream& operator<<(std::ostream& os, const IngestStats& stats)
+        {
+            os << "\n--------------- Shared Memory Ingest ---------------";
+            os << "\nFrames detected = " << stats.Frames;
+            os << "\nFailed frames = " << stats.Failures;
+            os << "\nResults with dropped detections = " << stats.TruncatedResults;
+            os << std::endl;
+
+            return os;
+        }
+    };
+
+    class SharedMemoryIngest
+    {
+    public:
+        /// Constructor
+        /// \param config The params of the detector (copied)
+        /// \param frameRingName The shared memory name of the frame ring (created by the capture process)
+        /// \param resultRingName The shared memory name of the result ring (created by this ingest, same slot count as the frame ring)
+        SharedMemoryIngest(const Config::DetectorConfig& config, std::string frameRingName, std::string resultRingName);
+
+        ~SharedMemoryIngest() = default;
+
+        /// Open the frame ring and create the result ring
+        /// \return Returns false if either ring could not be set up
+        bool Start();
+
+        /// Detect frames until Stop is called (Start must have succeeded)
+        void Run();
+
+        /// Let Run return after the current frame (safe to call from a signal handler)
+        void Stop();
+
+        /// Get the counters of the ingestion
+        const IngestStats& GetStats() const;
+
+        /// Get the latencies of the detected frames
+        Detection::LatencySummary GetLatencySummary() const;
+
+    private:
+        bool DetectSlot(const IO::FrameSlot& frame, IO::ResultSlot& result);
+        void Wait(int& idleRounds) const;
+
+    private:
+        Detection::DetectorSession m_Session;
+        std::string m_FrameRingName;
+        std::string m_ResultRingName;
+        IO::SharedMemoryRing m_Frames;
+        IO::SharedMemoryRing m_Results;
+        std::vector<Detection::FumaroleDetection> m_Detections;
+        std::atomic<bool> m_Stopping { false };
+        IngestStats m_Stats;
+    };
+}
+
+#endif //FUMAROLE_LOCALIZATION_SHAREDMEMORYINGEST_HPP
@@ -0,0 +1,388 @@
+//
+// FumaroleModule.cpp
+// Python bindings (module "fumarole") for the detector, the pipeline stages, the tracker and the evaluator
+// Frames are read in place through the buffer protocol (e.g. NumPy arrays, no copy) and detections are returned as
+// structured NumPy arrays. The GIL is released while a frame is processed so a Python thread pool scales across cores.
+//
+
+#include "config/ConfigParser.hpp"
+#include "config/DetectorConfig.hpp"
+#include "detection/FumaroleDetection.hpp"
+#include "detection/FumaroleDetector.hpp"
+#include "detection/DetectorSession.hpp"
+#include "detection/FumaroleTracker.hpp"
+#include "evaluation/AlgorithmEvaluator.hpp"
+#include "memory/FrameArena.hpp"
+#include "model/FumaroleType.hpp"
+#include "pipeline/ContourStore.hpp"
+#include "pipeline/Pipeline.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace Python
+{
+    /// A detection as a record of a structured array
+    struct DetectionRow
+    {
+        int32_t Type;
+        int32_t X;
+        int32_t Y;
+        int32_t Width;
+        int32_t Height;
+        float Score;
+    };
+
+    /// A contour of a pipeline stage as a record of a structured array
+    struct ContourRow
+    {
+        int32_t Band;
+        int32_t X;
+        int32_t Y;
+        int32_t Width;
+        int32_t Height;
+        float CentroidX;
+        float CentroidY;
+        double Area;
+        double Perimeter;
+        int32_t PeakIntensity;
+    };
+
+    typedef py::array_t<DetectionRow, py::array::c_style> DetectionArray;
+
+    // Header over the pixels of an 8-bit grayscale (H x W) or BGR (H x W x 3) buffer, the pixels are not copied
+    static cv::Mat FrameView(const py::buffer_info& info)
+    {
+        if (info.format != py::format_descriptor<uint8_t>::format()) {
+            throw std::invalid_argument("frame must be uint8");
+        }
+
+        if (info.ndim != 2 && !(info.ndim == 3 && info.shape[2] == 3)) {
+            throw std::invalid_argument("frame must be H x W (grayscale) or H x W x 3 (BGR)");
+        }
+
+        // rows may be padded (e.g. a crop of a larger array) but the pixels of a row must be contiguous
+        const ssize_t pixelSize = (info.ndim == 3 ? 3 : 1);
+        if (info.strides[1] != pixelSize || (info.ndim == 3 && info.strides[2] != 1) || info.strides[0] < info.shape[1] * pixelSize) {
+            throw std::invalid_argument("the pixels of each row of the frame must be contiguous");
+        }
+
+        return cv::Mat(static_cast<int>(info.shape[0]), static_cast<int>(info.shape[1]), (info.ndim == 3 ? CV_8UC3 : CV_8UC1),
+                       info.ptr, static_cast<size_t>(info.strides[0]));
+    }
+
+    // Structured array of the detections
+    static DetectionArray ToArray(const std::vector<Detection::FumaroleDetection>& detections)
+    {
+        DetectionArray array(static_cast<ssize_t>(detections.size()));
+        auto rows = array.mutable_unchecked<1>();
+
+        for (size_t i = 0; i < detections.size(); i++)
+        {
+            const Detection::FumaroleDetection& d = detections[i];
+            rows(i) = DetectionRow { static_cast<int32_t>(d.Type), d.BoundingBox.x, d.BoundingBox.y, d.BoundingBox.width, d.BoundingBox.height, d.Score };
+        }
+
+        return array;
+    }
+
+    // Detections of a structured array (without contours, so the mask IoU of the evaluation falls back to the boxes)
+    static std::vector<Detection::FumaroleDetection> FromArray(const DetectionArray& array)
+    {
+        if (array.ndim() != 1) {
+            throw std::invalid_argument("detections must be a 1-d structured array");
+        }
+
+        auto rows = array.unchecked<1>();
+        std::vector<Detection::FumaroleDetection> detections(static_cast<size_t>(rows.shape(0)));
+
+        for (ssize_t i = 0; i < rows.shape(0); i++)
+        {
+            const DetectionRow& row = rows(i);
+
+            // the type indexes fixed size tables (e.g. the confusion matrix of the evaluation)
+            if (row.Type < 0 || row.Type > Model::UNKNOWN) {
+                throw py::value_error("detection " + std::to_string(i) + " has an invalid type " + std::to_string(row.Type));
+            }
+
+            Detection::FumaroleDetection& d = detections[i];
+            d.Type = static_cast<Model::FumaroleType>(row.Type);
+            d.BoundingBox = cv::Rect(row.X, row.Y, row.Width, row.Height);
+            d.Score = row.Score;
+        }
+
+        return detections;
+    }
+
+    // Structured array of the contours of a store
+    static py::array_t<ContourRow> ToArray(const Pipeline::ContourStore& contours)
+    {
+        py::array_t<ContourRow> array(static_cast<ssize_t>(contours.Size()));
+        auto rows = array.mutable_unchecked<1>();
+
+        for (size_t i = 0; i < contours.Size(); i++)
+        {
+            const Pipeline::ContourFeatures& f = contours.Features(i);
+            rows(i) = ContourRow { contours.Band(i), f.BoundingBox.x, f.BoundingBox.y, f.BoundingBox.width, f.BoundingBox.height,
+                                   f.Centroid.x, f.Centroid.y, f.Area, f.Perimeter, f.PeakIntensity };
+        }
+
+        return array;
+    }
+
+    /// The pipeline stages up to the localizations (or the contours) of a frame, without the classification
+    /// Not thread safe (the element buffers are reused for every frame), use a pipeline per thread
+    class FramePipeline
+    {
+    public:
+        /// Constructor
+        /// \param config The params of the pipeline elements
+        /// \param lastStage The stage whose contours are returned
+        FramePipeline(const Config::PipelineConfig& config, Pipeline::PipelineStage lastStage) :
+            m_Pipeline({}, config, false, &m_Arena, lastStage)
+        {
+
+        }
+
+        /// Run the stages on a frame
+        /// \param frame The 8-bit grayscale frame (BGR frames are converted)
+        /// \return The contours of the last stage
+        py::array_t<ContourRow> Process(const py::buffer& frame)
+        {
+            const py::buffer_info info = frame.request();
+            const cv::Mat view = FrameView(info);
+
+            {
+                py::gil_scoped_release release;
+
+                const cv::Mat* gray = &view;
+                if (view.type() == CV_8UC3) {
+                    cv::cvtColor(view, m_Gray, cv::COLOR_BGR2GRAY);
+                    gray = &m_Gray;
+                }
+
+                m_Pipeline.ProcessFrame(*gray, "frame", m_Contours);
+            }
+
+            return ToArray(m_Contours);
+        }
+
+    private:
+        Memory::FrameArena m_Arena;
+        Pipeline::Pipeline m_Pipeline;
+        Pipeline::ContourStore m_Contours;
+        cv::Mat m_Gray;
+    };
+}
+
+PYBIND11_NUMPY_DTYPE_EX(Python::DetectionRow, Type, "type", X, "x", Y, "y", Width, "width", Height, "height", Score, "score");
+PYBIND11_NUMPY_DTYPE_EX(Python::ContourRow, Band, "band", X, "x", Y, "y", Width, "width", Height, "height",
+                        CentroidX, "centroid_x", CentroidY, "centroid_y", Area, "area", Perimeter, "perimeter", PeakIntensity, "peak_intensity");
+
+PYBIND11_MODULE(fumarole, m)
+{
+    using namespace Python;
+
+    m.doc() = "Fumarole detection and classification in thermal images";
+
+    // classes
+    py::enum_<Model::FumaroleType>(m, "FumaroleType")
+        .value("FUMAROLE_HOLE", Model::FUMAROLE_HOLE)
+        .value("FUMAROLE_OPEN_VENT", Model::FUMAROLE_OPEN_VENT)
+        .value("FUMAROLE_HIDDEN_VENT", Model::FUMAROLE_HIDDEN_VENT)
+        .value("FUMAROLE_HEATED_AREA", Model::FUMAROLE_HEATED_AREA)
+        .value("UNKNOWN", Model::UNKNOWN)
+        .export_values();
+
+    m.def("type_name", [](int type) { return Model::TypeNameString(static_cast<Model::FumaroleType>(type)); },
+          "Get the class label of a detection type", py::arg("type"));
+
+    m.def("detection_dtype", []() { return py::dtype::of<DetectionRow>(); }, "Get the dtype of the detection arrays");
+    m.def("contour_dtype", []() { return py::dtype::of<ContourRow>(); }, "Get the dtype of the contour arrays");
+
+    // config
+    py::class_<Config::PipelineConfig>(m, "PipelineConfig")
+        .def(py::init<>())
+        .def_readwrite("heat_ranges", &Config::PipelineConfig::HeatRanges)
+        .def_readwrite("threshold_method", &Config::PipelineConfig::ThresholdMethod)
+        .def_readwrite("adaptive_window_size", &Config::PipelineConfig::AdaptiveWindowSize)
+        .def_readwrite("adaptive_k", &Config::PipelineConfig::AdaptiveK)
+        .def_readwrite("pyramid_enabled", &Config::PipelineConfig::PyramidEnabled)
+        .def_readwrite("pyramid_levels", &Config::PipelineConfig::PyramidLevels)
+        .def_readwrite("pyramid_roi_padding", &Config::PipelineConfig::PyramidRoiPadding)
+        .def_readwrite("contour_min_area", &Config::PipelineConfig::ContourMinArea);
+
+    py::class_<Config::DetectionConfig>(m, "DetectionConfig")
+        .def(py::init<>())
+        .def_readwrite("min_area_heated_area", &Config::DetectionConfig::MinAreaHeatedArea)
+        .def_readwrite("open_vent_search_radius", &Config::DetectionConfig::OpenVentSearchRadius)
+        .def_readwrite("hidden_vent_search_radius", &Config::DetectionConfig::HiddenVentSearchRadius);
+
+    py::class_<Config::TrackingConfig>(m, "TrackingConfig")
+        .def(py::init<>())
+        .def_readwrite("gate_radius", &Config::TrackingConfig::GateRadius)
+        .def_readwrite("max_missed_frames", &Config::TrackingConfig::MaxMissedFrames)
+        .def_readwrite("velocity_smoothing", &Config::TrackingConfig::VelocitySmoothing);
+
+    py::class_<Config::EvaluationConfig>(m, "EvaluationConfig")
+        .def(py::init<>())
+        .def_readwrite("detection_threshold_min", &Config::EvaluationConfig::DetectionThresholdMin)
+        .def_readwrite("detection_threshold_max", &Config::EvaluationConfig::DetectionThresholdMax)
+        .def_readwrite("detection_threshold_step", &Config::EvaluationConfig::DetectionThresholdStep)
+        .def_readwrite("iou_threshold_step", &Config::EvaluationConfig::IoUThresholdStep)
+        .def_readwrite("matching_method", &Config::EvaluationConfig::MatchingMethod)
+        .def_readwrite("min_match_iou", &Config::EvaluationConfig::MinMatchIoU)
+        .def_readwrite("iou_mode", &Config::EvaluationConfig::IoUMode);
+
+    py::class_<Config::DetectorConfig>(m, "DetectorConfig")
+        .def(py::init<>())
+        .def_static("load", [](const std::string& filePath) {
+            Config::DetectorConfig config;
+            if (!Config::DetectorConfig::Load(filePath, config)) {
+                throw std::runtime_error("failed to read config " + filePath);
+            }
+
+            return config;
+        }, "Read the config from an XML config file", py::arg("file_path"))
+        .def_static("default", []() { return Config::ConfigParser::GetInstance().GetDetectorConfig(); },
+                    "Get the config of the config file of the detector programs")
+        .def_readwrite("pipeline", &Config::DetectorConfig::Pipeline)
+        .def_readwrite("detection", &Config::DetectorConfig::Detection)
+        .def_readwrite("tracking", &Config::DetectorConfig::Tracking)
+        .def_readwrite("evaluation", &Config::DetectorConfig::Evaluation);
+
+    // detector (reentrant, one detector can be shared by a thread pool)
+    py::class_<Detection::FumaroleDetector>(m, "Detector")
+        .def(py::init([](const Config::DetectorConfig& config) { return std::make_unique<Detection::FumaroleDetector>(config, false); }),
+             py::arg("config"))
+        .def("detect", [](const Detection::FumaroleDetector& detector, const py::buffer& frame) {
+            const py::buffer_info info = frame.request();
+            const cv::Mat view = FrameView(info);
+
+            std::vector<Detection::FumaroleDetection> detections;
+            bool detected;
+            {
+                py::gil_scoped_release release;
+                detected = detector.Detect(view, detections);
+            }
+
+            if (!detected) {
+                throw std::runtime_error("failed to detect fumaroles in the frame");
+            }
+
+            return ToArray(detections);
+        }, "Detect the fumaroles in an 8-bit grayscale or BGR frame (thread safe)", py::arg("frame"));
+
+    // session (a reused pipeline for a stream of frames, one per thread)
+    py::class_<Detection::DetectorSession>(m, "Session")
+        .def(py::init([](const Config::DetectorConfig& config) { return std::make_unique<Detection::DetectorSession>(config); }),
+             py::arg("config"))
+        .def("detect", [](Detection::DetectorSession& session, const py::buffer& frame) {
+            const py::buffer_info info = frame.request();
+            const cv::Mat view = FrameView(info);
+
+            std::vector<Detection::FumaroleDetection> detections;
+            bool detected;
+            {
+                py::gil_scoped_release release;
+                detected = session.Detect(view, detections);
+            }
+
+            if (!detected) {
+                throw std::runtime_error("failed to detect fumaroles in the frame");
+            }
+
+            return ToArray(detections);
+        }, "Detect the fumaroles in an 8-bit grayscale or BGR frame (not thread safe)", py::arg("frame"))
+        .def("latency", [](const Detection::DetectorSession& session) {
+            const Detection::LatencySummary summary = session.GetLatencySummary();
+
+            py::dict latency;
+            latency["frames"] = summary.Frames;
+            latency["mean"] = summary.Mean;
+            latency["p50"] = summary.P50;
+            latency["p95"] = summary.P95;
+            latency["p99"] = summary.P99;
+            latency["max"] = summary.Max;
+
+            return latency;
+        }, "Get the frame latencies in milliseconds")
+        .def("reset_latency", &Detection::DetectorSession::ResetLatencySummary)
+        .def_property_readonly("skipped_frames", &Detection::DetectorSession::GetSkippedFrameCount);
+
+    // pipeline stages
+    py::enum_<Pipeline::PipelineStage>(m, "PipelineStage")
+        .value("CONTOURS", Pipeline::PIPELINE_STAGE_CONTOURS)
+        .value("LOCALIZATIONS", Pipeline::PIPELINE_STAGE_LOCALIZATIONS);
+
+    py::class_<FramePipeline>(m, "Pipeline")
+        .def(py::init<const Config::PipelineConfig&, Pipeline::PipelineStage>(),
+             py::arg("config"), py::arg("last_stage") = Pipeline::PIPELINE_STAGE_LOCALIZATIONS)
+        .def("process", &FramePipeline::Process, "Get the contours of the last stage of a frame (not thread safe)", py::arg("frame"));
+
+    // tracker
+    py::class_<Detection::FumaroleTracker>(m, "Tracker")
+        .def(py::init<const Config::TrackingConfig&>(), py::arg("config"))
+        .def("update", [](Detection::FumaroleTracker& tracker, const DetectionArray& detections) {
+            const std::vector<Detection::FumaroleDetection> frameDetections = FromArray(detections);
+
+            std::vector<uint64_t> trackIDs;
+            tracker.Update(frameDetections, trackIDs);
+
+            py::array_t<uint64_t> ids(static_cast<ssize_t>(trackIDs.size()));
+            std::copy(trackIDs.begin(), trackIDs.end(), ids.mutable_data());
+
+            return ids;
+        }, "Get the track ID of each detection of the next frame", py::arg("detections"))
+        .def("reset", &Detection::FumaroleTracker::Reset);
+
+    // evaluator
+    py::class_<Evaluation::AlgorithmEvaluator>(m, "Evaluator")
+        .def(py::init<const Config::EvaluationConfig&>(), py::arg("config"))
+        .def("evaluate", [](const Evaluation::AlgorithmEvaluator& evaluator, const std::map<std::string, DetectionArray>& results, const std::map<std::string, DetectionArray>& truth) {
+            std::map<std::string, std::vector<Detection::FumaroleDetection>> resultDetections;
+            std::map<std::string, std::vector<Detection::FumaroleDetection>> truthDetections;
+
+            for (const auto& image : results) {
+                resultDetections[image.first] = FromArray(image.second);
+            }
+
+            for (const auto& image : truth) {
+                truthDetections[image.first] = FromArray(image.second);
+            }
+
+            Evaluation::AlgorithmEvaluation evaluation;
+            {
+                py::gil_scoped_release release;
+                evaluation = evaluator.EvaluateDetectionPipeline(resultDetections, truthDetections);
+            }
+
+            py::dict averagePrecision;
+            for (const auto& c : evaluation.Matching.Classes) {
+                averagePrecision[py::str(Model::TypeNameString(c.first))] = c.second.AveragePrecision;
+            }
+
+            py::dict summary;
+            summary["actual"] = evaluation.TotalNumberOfActualFumaroles;
+            summary["detected"] = evaluation.TotalNumberDetected;
+            summary["average_iou"] = evaluation.TotalAverageIoU;
+            summary["map"] = evaluation.Matching.MeanAveragePrecision;
+            summary["map50"] = evaluation.Matching.MeanAveragePrecision50;
+            summary["map75"] = evaluation.Matching.MeanAveragePrecision75;
+            summary["average_precision"] = averagePrecision;
+
+            return summary;
+        }, "Evaluate the detections of each image (file id: detections) against the ground truth", py::arg("results"), py::arg("truth"));
+}
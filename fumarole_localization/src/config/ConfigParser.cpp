@@ -13,19 +13,24 @@
 
 namespace Config
 {
-    // Instance setup
-    ConfigParser& ConfigParser::GetInstance()
+    // Constructor
+    ConfigParser::ConfigParser()
     {
-        static ConfigParser instance;
-
         // copy sample config and create folder if not exists
         CheckAndCreateDefaultConfig();
 
-        // read xml file into memory if not read yet
-        if (instance.m_PropertyTree == nullptr) {
-            instance.m_PropertyTree = std::unique_ptr<boost::property_tree::ptree>(new boost::property_tree::ptree);
-            boost::property_tree::read_xml(CONFIG_FILE_PATH, *instance.m_PropertyTree);
-        }
+        // read xml file into memory
+        m_PropertyTree = std::unique_ptr<boost::property_tree::ptree>(new boost::property_tree::ptree);
+        boost::property_tree::read_xml(CONFIG_FILE_PATH, *m_PropertyTree);
+
+        m_DetectorConfig = DetectorConfig::FromPropertyTree(*m_PropertyTree);
+    }
+
+    // Instance setup
+    ConfigParser& ConfigParser::GetInstance()
+    {
+        // initialized once even if called from several threads at the same time
+        static ConfigParser instance;
 
         return instance;
     }
@@ -44,5 +49,9 @@ namespace Config
             }
         }
     }
-}
 
+    // Get the snapshot
+    const DetectorConfig& ConfigParser::GetDetectorConfig() const {
+        return m_DetectorConfig;
+    }
+}
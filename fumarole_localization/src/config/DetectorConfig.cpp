@@ -0,0 +1,134 @@
+//
+// DetectorConfig.cpp
+// Typed, immutable snapshot of the config values used by the pipeline, the detector and the evaluation
+//
+
+#include "config/DetectorConfig.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <boost/algorithm/string.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+namespace Config
+{
+    // Lowest heat range
+    int PipelineConfig::LowestHeatRange() const
+    {
+        int lowest = 255;
+        for (int range : HeatRanges) {
+            lowest = std::min(lowest, range);
+        }
+
+        return lowest;
+    }
+
+    // Pipeline fingerprint
+    std::string PipelineConfig::Fingerprint() const
+    {
+        std::ostringstream ss;
+        ss << "bins=";
+        for (int range : HeatRanges) {
+            ss << range << " ";
+        }
+
+        ss << ";threshold=" << ThresholdMethod;
+        ss << ";window=" << AdaptiveWindowSize << ";k=" << AdaptiveK;
+        ss << ";pyramid=" << PyramidEnabled << ";levels=" << PyramidLevels << ";padding=" << PyramidRoiPadding;
+        ss << ";min_area=" << ContourMinArea;
+
+        return ss.str();
+    }
+
+    // Detection fingerprint
+    std::string DetectionConfig::Fingerprint() const
+    {
+        std::ostringstream ss;
+        ss << "heated_area=" << MinAreaHeatedArea << ";open_vent=" << OpenVentSearchRadius << ";hidden_vent=" << HiddenVentSearchRadius;
+
+        return ss.str();
+    }
+
+    // Read from the property tree
+    DetectorConfig DetectorConfig::FromPropertyTree(const boost::property_tree::ptree& tree)
+    {
+        DetectorConfig config;
+
+        // pipeline
+        std::string bins = tree.get<std::string>("config.pipeline.histogram.bins");
+        std::vector<std::string> binValues;
+        boost::trim(bins);
+        boost::split(binValues, bins, boost::is_space(), boost::token_compress_on);
+
+        for (const std::string& value : binValues) {
+            config.Pipeline.HeatRanges.push_back(std::stoi(value));
+        }
+
+        config.Pipeline.ThresholdMethod = tree.get<std::string>("config.pipeline.threshold.method", "heat");
+        config.Pipeline.AdaptiveWindowSize = tree.get<int>("config.pipeline.adaptive_threshold.window_size", 51);
+        config.Pipeline.AdaptiveK = tree.get<float>("config.pipeline.adaptive_threshold.k", 1.0f);
+        config.Pipeline.PyramidEnabled = tree.get<bool>("config.pipeline.pyramid.enabled", false);
+        config.Pipeline.PyramidLevels = tree.get<int>("config.pipeline.pyramid.levels", 2);
+        config.Pipeline.PyramidRoiPadding = tree.get<int>("config.pipeline.pyramid.roi_padding", 16);
+        config.Pipeline.ContourMinArea = tree.get<float>("config.pipeline.contour.min_area");
+
+        // classification
+        config.Detection.MinAreaHeatedArea = tree.get<float>("config.detection.min_area_heated_area");
+        config.Detection.OpenVentSearchRadius = tree.get<float>("config.detection.open_vent_radius_search");
+        config.Detection.HiddenVentSearchRadius = tree.get<float>("config.detection.hidden_area_radius_search");
+
+        // result cache
+        config.Cache.Enabled = tree.get<bool>("config.cache.enabled", false);
+        config.Cache.Directory = tree.get<std::string>("config.cache.directory", "result_cache");
+
+        // world coordinate de-duplication (only used with frame homographies)
+        config.Deduplication.MergeRadius = tree.get<double>("config.deduplication.merge_radius", config.Deduplication.MergeRadius);
+
+        // tracking (only used for video sequences)
+        config.Tracking.GateRadius = tree.get<float>("config.tracking.gate_radius", config.Tracking.GateRadius);
+        config.Tracking.MaxMissedFrames = tree.get<int>("config.tracking.max_missed_frames", config.Tracking.MaxMissedFrames);
+        config.Tracking.VelocitySmoothing = tree.get<float>("config.tracking.velocity_smoothing", config.Tracking.VelocitySmoothing);
+
+        // detection server (only used when serving), invalid values are clamped to the nearest valid one
+        const int workers = tree.get<int>("config.server.workers", 0);
+        config.Server.Workers = (workers > 0 ? workers : static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)));
+        config.Server.MaxBatchSize = std::max(tree.get<int>("config.server.max_batch_size", config.Server.MaxBatchSize), 1);
+        config.Server.MaxConnections = std::max(tree.get<int>("config.server.max_connections", config.Server.MaxConnections), 1);
+
+        // read signed so a negative value is not wrapped around to a huge limit
+        const int64_t maxFrameBytes = tree.get<int64_t>("config.server.max_frame_bytes", static_cast<int64_t>(config.Server.MaxFrameBytes));
+        config.Server.MaxFrameBytes = static_cast<uint64_t>(std::max<int64_t>(maxFrameBytes, 1));
+
+        // evaluation (only required by the programs that evaluate)
+        config.Evaluation.DetectionThresholdMin = tree.get<int>("config.evaluation.detection.threshold_min", config.Evaluation.DetectionThresholdMin);
+        config.Evaluation.DetectionThresholdMax = tree.get<int>("config.evaluation.detection.threshold_max", config.Evaluation.DetectionThresholdMax);
+        config.Evaluation.DetectionThresholdStep = tree.get<int>("config.evaluation.detection.threshold_step", config.Evaluation.DetectionThresholdStep);
+        config.Evaluation.IoUThresholdStep = tree.get<float>("config.evaluation.detection.iou_threshold_step", config.Evaluation.IoUThresholdStep);
+        config.Evaluation.MatchingMethod = tree.get<std::string>("config.evaluation.matching.method", config.Evaluation.MatchingMethod);
+        config.Evaluation.MinMatchIoU = tree.get<float>("config.evaluation.matching.min_iou", config.Evaluation.MinMatchIoU);
+        config.Evaluation.IoUMode = tree.get<std::string>("config.evaluation.matching.iou_mode", config.Evaluation.IoUMode);
+
+        return config;
+    }
+
+    // Read from a file
+    bool DetectorConfig::Load(const std::string& filePath, DetectorConfig& config)
+    {
+        try
+        {
+            boost::property_tree::ptree tree;
+            boost::property_tree::read_xml(filePath, tree);
+
+            config = FromPropertyTree(tree);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "\nFailed to read config " << filePath << ": " << e.what() << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,151 @@
+//
+// DetectorSession.cpp
+// Long-lived detector for a stream of frames with per-frame latency stats
+//
+
+#include "detection/DetectorSession.hpp"
+#include "config/ConfigParser.hpp"
+
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <opencv2/imgproc/imgproc.hpp>
+
+namespace Detection
+{
+    const std::string SESSION_FRAME_ID { "frame" };
+
+    // Nearest-rank percentile of sorted values
+    static double Percentile(const std::vector<double>& sorted, double percentile)
+    {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+
+        const size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(sorted.size())));
+        return sorted[std::min(std::max(rank, size_t(1)), sorted.size()) - 1];
+    }
+
+    // Constructor
+    DetectorSession::DetectorSession() : DetectorSession(Config::ConfigParser::GetInstance().GetDetectorConfig())
+    {
+
+    }
+
+    // Constructor with explicit params
+    DetectorSession::DetectorSession(const Config::DetectorConfig& config) :
+        m_Detector(config, false), m_Pipeline({}, config.Pipeline, false, &m_Arena)
+    {
+        m_Latencies.reserve(LATENCY_WINDOW);
+    }
+
+    // Detect on a frame
+    bool DetectorSession::Detect(const cv::Mat& frame, std::vector<FumaroleDetection>& detections)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        detections.clear();
+
+        const cv::Mat* gray = &frame;
+        if (frame.type() == CV_8UC3) {
+            cv::cvtColor(frame, m_Gray, cv::COLOR_BGR2GRAY);
+            gray = &m_Gray;
+        }
+        else if (frame.type() != CV_8UC1) {
+            std::cerr << "\nUnsupported frame type for detection: " << frame.type() << std::endl;
+            return false;
+        }
+
+        if (gray->empty()) {
+            std::cerr << "\nCannot detect on an empty frame" << std::endl;
+            return false;
+        }
+
+        try
+        {
+            m_Pipeline.ProcessFrame(*gray, SESSION_FRAME_ID, m_Localizations);
+            detections = m_Detector.ClassifyLocalizations(m_Localizations, m_Arena);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "\nFailed to process frame: " << e.what() << std::endl;
+            detections.clear();
+            m_Arena.Release();
+            return false;
+        }
+
+        const auto end = std::chrono::steady_clock::now();
+        RecordLatency(std::chrono::duration<double, std::milli>(end - start).count());
+
+        return true;
+    }
+
+    // Detect on raw pixels
+    bool DetectorSession::Detect(const uint8_t* data, int width, int height, size_t stride, std::vector<FumaroleDetection>& detections)
+    {
+        if (data == nullptr || width <= 0 || height <= 0 || stride < static_cast<size_t>(width))
+        {
+            std::cerr << "\nInvalid frame for detection: " << width << "x" << height << " with stride " << stride << std::endl;
+            detections.clear();
+            return false;
+        }
+
+        // header over the caller's pixels (the pipeline only reads its input)
+        const cv::Mat frame(height, width, CV_8UC1, const_cast<uint8_t*>(data), stride);
+
+        return Detect(frame, detections);
+    }
+
+    // Latency summary
+    LatencySummary DetectorSession::GetLatencySummary() const
+    {
+        LatencySummary summary;
+        summary.Frames = m_Frames;
+
+        if (m_Frames == 0) {
+            return summary;
+        }
+
+        std::vector<double> sorted(m_Latencies);
+        std::sort(sorted.begin(), sorted.end());
+
+        summary.Mean = m_TotalLatency / static_cast<double>(m_Frames);
+        summary.P50 = Percentile(sorted, 50.0);
+        summary.P95 = Percentile(sorted, 95.0);
+        summary.P99 = Percentile(sorted, 99.0);
+        summary.Max = m_MaxLatency;
+
+        return summary;
+    }
+
+    // Reset the latency stats
+    void DetectorSession::ResetLatencySummary()
+    {
+        m_Latencies.clear();
+        m_NextLatency = 0;
+        m_Frames = 0;
+        m_TotalLatency = 0.0;
+        m_MaxLatency = 0.0;
+    }
+
+    // Skipped frames
+    int DetectorSession::GetSkippedFrameCount() const {
+        return m_Pipeline.GetSkippedFrameCount();
+    }
+
+    // Record the latency of a frame
+    void DetectorSession::RecordLatency(double milliseconds)
+    {
+        if (m_Latencies.size() < LATENCY_WINDOW) {
+            m_Latencies.push_back(milliseconds);
+        }
+        else {
+            m_Latencies[m_NextLatency] = milliseconds;
+        }
+
+        m_NextLatency = (m_NextLatency + 1) % LATENCY_WINDOW;
+        m_Frames++;
+        m_TotalLatency += milliseconds;
+        m_MaxLatency = std::max(m_MaxLatency, milliseconds);
+    }
+}
@@ -8,8 +8,11 @@
 #include "config/config.hpp"
 #include "config/ConfigParser.hpp"
 #include "io/fumarole_data_io.hpp"
+#include "io/ResultCache.hpp"
+#include "io/BatchJournal.hpp"
 
 #include <map>
+#include <unordered_map>
 #include <algorithm>
 #include <boost/filesystem.hpp>
 #include <opencv2/core/core.hpp>
@@ -20,14 +23,18 @@ namespace Detection
 {
     const int FUMAROLE_HOLE_RADIUS { 5 };
     const int DRAW_THICKNESS { 3 };
+    const std::string IN_MEMORY_FRAME_ID { "frame" };
 
     // Constructor
-    FumaroleDetector::FumaroleDetector(bool saveIntermediateResults) : m_SaveResults(saveIntermediateResults)
+    FumaroleDetector::FumaroleDetector(bool saveIntermediateResults) : FumaroleDetector(Config::ConfigParser::GetInstance().GetDetectorConfig(), saveIntermediateResults)
     {
-        // load params from config file
-        m_MinAreaForHeatedArea = Config::ConfigParser::GetInstance().GetValue<float>("config.detection.min_area_heated_area");
-        m_OpenVentSearchRadius = Config::ConfigParser::GetInstance().GetValue<float>("config.detection.open_vent_radius_search");
-        m_HiddenVentSearchRadius = Config::ConfigParser::GetInstance().GetValue<float>("config.detection.hidden_area_radius_search");
+
+    }
+
+    // Constructor with explicit params
+    FumaroleDetector::FumaroleDetector(const Config::DetectorConfig& config, bool saveIntermediateResults) : m_Config(config), m_SaveResults(saveIntermediateResults)
+    {
+
     }
 
     // Destructor
@@ -37,7 +44,7 @@ namespace Detection
     }
 
     // One-shot detection on single thermal image
-    bool FumaroleDetector::DetectFumaroles(const std::string& fileID, const std::string &thermalImagePath, std::vector<Detection::FumaroleDetection> &results) const
+    bool FumaroleDetector::DetectFumaroles(const std::string& fileID, const std::string &thermalImagePath, std::vector<Detection::FumaroleDetection> &results)
     {
         // create the input map for the pipeline
         std::map<std::string, std::string> pipelineInput;
@@ -47,122 +54,350 @@ namespace Detection
         std::map<std::string, std::vector<Detection::FumaroleDetection>> multipleFileResults;
         if (DetectFumaroles(pipelineInput, multipleFileResults))
         {
-            results = std::move(multipleFileResults[fileID]);
-            return true;
+            // the image has no results if it failed
+            auto iter = multipleFileResults.find(fileID);
+            if (iter != multipleFileResults.end()) {
+                results = std::move(iter->second);
+                return true;
+            }
         }
 
         return false;
     }
 
-    bool FumaroleDetector::DetectFumaroles(const std::map<std::string, std::string> &files, std::map<std::string, std::vector<Detection::FumaroleDetection>> &results) const
+    bool FumaroleDetector::DetectFumaroles(const std::map<std::string, std::string> &files, std::map<std::string, std::vector<Detection::FumaroleDetection>> &results)
     {
+        results.clear();
+
+        // collect the streamed detections into the map
+        return DetectFumaroles(files, [&](const std::string& fileID, const std::vector<FumaroleDetection>& detections) {
+            results[fileID] = detections;
+        });
+    }
+
+    bool FumaroleDetector::DetectFumaroles(const std::map<std::string, std::string> &files, const DetectionSink& sink)
+    {
+        std::map<std::string, std::string> pipelineFiles;
+        std::unordered_map<std::string, uint64_t> cacheKeys;
+        std::unique_ptr<IO::ResultCache> cache;
+
+        if (m_Config.Cache.Enabled) {
+            cache = CreateResultCache();
+        }
+
+        uint64_t key = 0;
+        std::vector<Detection::FumaroleDetection> detections;
+
+        for (const auto& file : files)
+        {
+            // images completed in a previous run of the journal are not processed again, their journaled detections are
+            // delivered instead so a resumed run has the same output as an uninterrupted one (failed ones are skipped)
+            if (m_Journal && m_Journal->IsRecorded(file.first))
+            {
+                try
+                {
+                    if (m_Journal->ReadCompleted(file.first, detections)) {
+                        sink(file.first, detections);
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    // already journaled as completed, so it is delivered again by the next resumed run
+                    std::cerr << "\nFailed to deliver " << file.first << ": " << e.what() << std::endl;
+                    m_Summary.FailedFrames++;
+                }
+
+                m_Summary.ResumedFrames++;
+                continue;
+            }
+
+            // serve unchanged images from the cache and only run the pipeline on the others
+            if (cache)
+            {
+                if (cache->Lookup(file.second, key, detections))
+                {
+                    // as in the pipeline, an image is failed if the sink throws (e.g. its results could not be written)
+                    try
+                    {
+                        sink(file.first, detections);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        std::cerr << "\nFailed to deliver " << file.first << ": " << e.what() << std::endl;
+                        m_Summary.FailedFrames++;
+
+                        if (m_Journal && !m_Journal->AppendFailed(file.first, e.what())) {
+                            std::cerr << "\nStopping the batch, the journal cannot be written" << std::endl;
+                            return false;
+                        }
+
+                        continue;
+                    }
+
+                    if (m_Journal && !m_Journal->AppendCompleted(file.first, detections)) {
+                        std::cerr << "\nStopping the batch, the journal cannot be written" << std::endl;
+                        return false;
+                    }
+
+                    m_Summary.CacheHits++;
+                    continue;
+                }
+
+                cacheKeys[file.first] = key;
+                m_Summary.CacheMisses++;
+            }
+
+            pipelineFiles.insert(file);
+        }
+
         // create a detection pipeline
-        Pipeline::Pipeline pipeline(files, m_SaveResults);
+        Pipeline::Pipeline pipeline(pipelineFiles, m_Config.Pipeline, m_SaveResults, &m_Arena);
+        if (m_ImageLoader) {
+            pipeline.SetImageLoader(m_ImageLoader);
+        }
+
+        // only the frames the pipeline ran on and delivered count as processed (resumed frames, cache hits, failures and cold
+        // frames are counted apart), a cold frame is recognized by the skipped count having changed since the last callback
+        int processedFrames = 0;
+        int coldFrames = 0;
+
+        // each image is classified and delivered as soon as the pipeline is done with it (nothing is kept for the whole batch)
+        pipeline.SetLocalizationCallback([&](const std::string& fileID, const Pipeline::ContourStore& localizations) {
+            const bool cold = pipeline.GetSkippedFrameCount() != coldFrames;
+            coldFrames = pipeline.GetSkippedFrameCount();
+
+            std::vector<FumaroleDetection> imageDetections = ClassifyLocalizations(localizations, m_Arena);
+
+            if (cache) {
+                cache->Store(cacheKeys[fileID], imageDetections);
+            }
+
+            sink(fileID, imageDetections);
+
+            if (!cold) {
+                processedFrames++;
+            }
+
+            // journaled after delivery so an image is never recorded as completed without its results having been written,
+            // a run that cannot journal its images any more is stopped instead of reporting images that a resume would redo
+            if (m_Journal && !m_Journal->AppendCompleted(fileID, imageDetections))
+            {
+                std::cerr << "\nStopping the batch, the journal cannot be written" << std::endl;
+                pipeline.Stop();
+            }
+        });
+
+        pipeline.SetFailureCallback([&](const std::string& fileID, const std::string& reason) {
+            if (m_Journal && !m_Journal->AppendFailed(fileID, reason))
+            {
+                std::cerr << "\nStopping the batch, the journal cannot be written" << std::endl;
+                pipeline.Stop();
+            }
+        });
+
+        // run pipeline (false if it was stopped)
+        const bool completed = pipeline.Run();
+
+        m_Summary.ProcessedFrames += processedFrames;
+        m_Summary.SkippedColdFrames += pipeline.GetSkippedFrameCount();
+        m_Summary.FailedFrames += static_cast<int>(pipeline.GetFailures().size());
+        m_Summary.Allocations = m_Arena.Stats();
+
+        return completed;
+    }
+
+    // Detect on an in-memory frame
+    bool FumaroleDetector::Detect(const cv::Mat& frame, std::vector<FumaroleDetection>& detections) const
+    {
+        detections.clear();
+
+        cv::Mat gray;
+        if (frame.type() == CV_8UC1) {
+            gray = frame;
+        }
+        else if (frame.type() == CV_8UC3) {
+            cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+        }
+        else {
+            std::cerr << "\nUnsupported frame type for detection: " << frame.type() << std::endl;
+            return false;
+        }
 
-        // run pipeline
-        if (pipeline.Run())
+        if (gray.empty()) {
+            std::cerr << "\nCannot detect on an empty frame" << std::endl;
+            return false;
+        }
+
+        // nothing shared with other calls (the member arena is only used by the file based runs)
+        Memory::FrameArena arena;
+        Pipeline::Pipeline pipeline({}, m_Config.Pipeline, false, &arena);
+        Pipeline::ContourStore localizations;
+
+        try
+        {
+            pipeline.ProcessFrame(gray, IN_MEMORY_FRAME_ID, localizations);
+            detections = ClassifyLocalizations(localizations, arena.Resource());
+        }
+        catch (const std::exception& e)
         {
-            // convert localizations of pipelines into results
-            results = std::move(ConvertLocalizations(pipeline.GetLocalizations(), Model::FumaroleType::FUMAROLE_OPEN_VENT));
-            return true;
+            std::cerr << "\nFailed to process frame: " << e.what() << std::endl;
+            detections.clear();
+            return false;
         }
 
-        return false;
+        return true;
     }
 
-    // Convert localizations from pipeline into detection results
-    std::map<std::string, std::vector<FumaroleDetection>> FumaroleDetector::ConvertLocalizations(const Pipeline::PipelineLocalizations &localizations, Model::FumaroleType type) const
+    // Detect on raw pixels
+    bool FumaroleDetector::Detect(const uint8_t* data, int width, int height, size_t stride, std::vector<FumaroleDetection>& detections) const
     {
-        std::map<std::string, std::vector<FumaroleDetection>> results;
-        cv::Rect rect;
-        FumaroleDetection detectionResult;
-
-        // process each set of localizations for each image
-        for (const auto& localization : localizations) {
-            // classify current localizations
-            results[localization.first] = std::move(ClassifyLocalizations(localization.second));
+        if (data == nullptr || width <= 0 || height <= 0 || stride < static_cast<size_t>(width))
+        {
+            std::cerr << "\nInvalid frame for detection: " << width << "x" << height << " with stride " << stride << std::endl;
+            detections.clear();
+            return false;
         }
 
-        return std::move(results);
+        // header over the caller's pixels (the pipeline only reads its input)
+        const cv::Mat frame(height, width, CV_8UC1, const_cast<uint8_t*>(data), stride);
+
+        return Detect(frame, detections);
+    }
+
+    // Set the journal
+    void FumaroleDetector::SetJournal(IO::BatchJournal* journal) {
+        m_Journal = journal;
+    }
+
+    // Set the image loader
+    void FumaroleDetector::SetImageLoader(Pipeline::ImageLoader loader) {
+        m_ImageLoader = std::move(loader);
+    }
+
+    // Create the result cache for the current config
+    std::unique_ptr<IO::ResultCache> FumaroleDetector::CreateResultCache() const
+    {
+        // the effective config is everything the pipeline and the classification read
+        const std::string pipelineConfig = m_Config.Pipeline.Fingerprint();
+        const std::string detectionConfig = m_Config.Detection.Fingerprint();
+
+        uint64_t configHash = IO::ResultCache::Hash(pipelineConfig.data(), pipelineConfig.size());
+        configHash = IO::ResultCache::Hash(detectionConfig.data(), detectionConfig.size(), configHash);
+
+        return std::make_unique<IO::ResultCache>(m_Config.Cache.Directory, configHash);
+    }
+
+    // Classify the localizations of a single image
+    std::vector<FumaroleDetection> FumaroleDetector::ClassifyLocalizations(const Pipeline::ContourStore &contours, Memory::FrameArena& arena) const
+    {
+        std::vector<FumaroleDetection> detections = ClassifyLocalizations(contours, arena.Resource());
+
+        // temporaries of the classification are not needed anymore
+        arena.Release();
+
+        return detections;
     }
 
     // Classify current localizations (holes and heated areas)
-    std::vector<FumaroleDetection> FumaroleDetector::ClassifyLocalizations(const std::vector<std::vector<cv::Point>> &contours) const
+    std::vector<FumaroleDetection> FumaroleDetector::ClassifyLocalizations(const Pipeline::ContourStore &contours, std::pmr::memory_resource* resource) const
     {
          std::vector<FumaroleDetection> detections;
+         detections.reserve(contours.Size());
 
-         for (const auto& contour : contours)
+         for (size_t i = 0; i < contours.Size(); i++)
          {
              FumaroleDetection detection;
+             const Pipeline::ContourFeatures& features = contours.Features(i);
 
-             detection.Type = (cv::contourArea(contour) >= m_MinAreaForHeatedArea ? Model::FumaroleType::FUMAROLE_HEATED_AREA : Model::FumaroleType::FUMAROLE_HOLE);
-             detection.BoundingBox = cv::boundingRect(contour);
-             detection.Contour = contour;
+             // area and bounding box were computed when the contour was found
+             detection.Type = (features.Area >= m_Config.Detection.MinAreaHeatedArea ? Model::FumaroleType::FUMAROLE_HEATED_AREA : Model::FumaroleType::FUMAROLE_HOLE);
+             detection.BoundingBox = features.BoundingBox;
+             detection.Contour = contours.CopyPoints(i);
+             detection.Features = features;
+             detection.Score = static_cast<float>(features.PeakIntensity) / 255.0f;
 
              detections.emplace_back(std::move(detection));
          }
 
          // add open vents
-         std::vector<FumaroleDetection> openVents = std::move(DetectOpenVents(detections));
+         std::vector<FumaroleDetection> openVents = DetectOpenVents(detections, resource);
          detections.insert(detections.end(), openVents.begin(), openVents.end());
 
          // add hidden vents
-         std::vector<FumaroleDetection> hiddenVents = std::move(DetectHiddenVents(detections));
+         std::vector<FumaroleDetection> hiddenVents = DetectHiddenVents(detections, resource);
          detections.insert(detections.end(), hiddenVents.begin(), hiddenVents.end());
 
-         return std::move(detections);
+         return detections;
     }
 
     // Get classifications for open vents
-    std::vector<FumaroleDetection> FumaroleDetector::DetectOpenVents(const std::vector<FumaroleDetection>& detections) const
+    std::vector<FumaroleDetection> FumaroleDetector::DetectOpenVents(const std::vector<FumaroleDetection>& detections, std::pmr::memory_resource* resource) const
     {
-        // get all detected holes and cluster them into open vents
-        std::vector<FumaroleDetection> holes;
-        std::copy_if(detections.begin(), detections.end(), std::back_inserter(holes), [](const FumaroleDetection& d){ return d.Type == Model::FumaroleType::FUMAROLE_HOLE; });
-        return std::move(ClusterDetections(holes, m_OpenVentSearchRadius, Model::FumaroleType::FUMAROLE_OPEN_VENT));
+        // get the indices of all detected holes and cluster them into open vents
+        std::pmr::vector<size_t> holes(resource);
+        for (size_t i = 0; i < detections.size(); i++) {
+            if (detections[i].Type == Model::FumaroleType::FUMAROLE_HOLE) {
+                holes.push_back(i);
+            }
+        }
+
+        return ClusterDetections(detections, holes, m_Config.Detection.OpenVentSearchRadius, Model::FumaroleType::FUMAROLE_OPEN_VENT, resource);
     }
 
-    std::vector<FumaroleDetection> FumaroleDetector::DetectHiddenVents(const std::vector<FumaroleDetection> &detections) const
+    std::vector<FumaroleDetection> FumaroleDetector::DetectHiddenVents(const std::vector<FumaroleDetection> &detections, std::pmr::memory_resource* resource) const
     {
-        // get all detected heated areas and cluster them into hidden vents
-        std::vector<FumaroleDetection> heatedAreas;
-        std::copy_if(detections.begin(), detections.end(), std::back_inserter(heatedAreas), [](const FumaroleDetection& d){ return d.Type == Model::FumaroleType::FUMAROLE_HEATED_AREA; });
-        return std::move(ClusterDetections(heatedAreas, m_HiddenVentSearchRadius, Model::FumaroleType::FUMAROLE_HIDDEN_VENT));
+        // get the indices of all detected heated areas and cluster them into hidden vents
+        std::pmr::vector<size_t> heatedAreas(resource);
+        for (size_t i = 0; i < detections.size(); i++) {
+            if (detections[i].Type == Model::FumaroleType::FUMAROLE_HEATED_AREA) {
+                heatedAreas.push_back(i);
+            }
+        }
+
+        return ClusterDetections(detections, heatedAreas, m_Config.Detection.HiddenVentSearchRadius, Model::FumaroleType::FUMAROLE_HIDDEN_VENT, resource);
     }
 
-    // Cluster the given detections based on a radius search
-    std::vector<FumaroleDetection> FumaroleDetector::ClusterDetections(const std::vector<FumaroleDetection>& detections, float radius, Model::FumaroleType type) const
+    // Cluster the detections with the given indices based on a radius search
+    std::vector<FumaroleDetection> FumaroleDetector::ClusterDetections(const std::vector<FumaroleDetection>& detections, const std::pmr::vector<size_t>& indices, float radius, Model::FumaroleType type, std::pmr::memory_resource* resource) const
     {
         std::vector<FumaroleDetection> clusteredDetections;
 
-        if (detections.empty()) {
+        if (indices.empty()) {
             return clusteredDetections;
         }
 
         // convert to vector of centroids
-        std::vector<cv::Point2f> centroids;
-        std::transform(detections.begin(), detections.end(), std::back_inserter(centroids), [](const FumaroleDetection& d) -> cv::Point2f {
-            return d.Center();
-        });
+        std::pmr::vector<cv::Point2f> centroids(resource);
+        centroids.reserve(indices.size());
+        for (size_t index : indices) {
+            centroids.push_back(detections[index].Center());
+        }
 
         // get index graph of radius search
-        std::map<int, std::vector<int>> matchedIndices;
+        std::pmr::vector<std::pmr::vector<int>> matchedIndices(resource);
         RadiusSearch(centroids, matchedIndices, radius);
 
         // cluster into open vents
-        std::vector<bool> used(detections.size(), false);
-        std::vector<cv::Rect> boxes;
+        std::pmr::vector<bool> used(indices.size(), false, resource);
+        std::pmr::vector<cv::Rect> boxes(resource);
 
-        for (auto iter = matchedIndices.begin(); iter != matchedIndices.end(); iter++)
+        for (size_t i = 0; i < matchedIndices.size(); i++)
         {
-            used[iter->first] = true;
-            boxes.push_back(detections[iter->first].BoundingBox);
+            // only points with neighbours start a cluster
+            if (matchedIndices[i].empty()) {
+                continue;
+            }
+
+            used[i] = true;
+            boxes.push_back(detections[indices[i]].BoundingBox);
+            float score = detections[indices[i]].Score;
 
-            for (int index : iter->second)
+            for (int index : matchedIndices[i])
             {
                 if (!used[index]) {
                     // get all bounding boxes from the detections with these indices
-                    boxes.push_back(detections[index].BoundingBox);
+                    boxes.push_back(detections[indices[index]].BoundingBox);
+                    score = std::max(score, detections[indices[index]].Score);
                     used[index] = true;
                 }
             }
@@ -173,6 +408,7 @@ namespace Detection
                 FumaroleDetection detection;
                 detection.Type = type;
                 detection.BoundingBox = EnclosingBoundingBox(boxes);
+                detection.Score = score;
 
                 clusteredDetections.push_back(detection);
             }
@@ -180,13 +416,16 @@ namespace Detection
             boxes.clear();
         }
 
-        return std::move(clusteredDetections);
+        return clusteredDetections;
     }
 
     // Radius search for each point
-    void FumaroleDetector::RadiusSearch(const std::vector<cv::Point2f> &centroids,
-                                        std::map<int, std::vector<int>> &matchedIndices, float radius) const
+    void FumaroleDetector::RadiusSearch(const std::pmr::vector<cv::Point2f> &centroids,
+                                        std::pmr::vector<std::pmr::vector<int>> &matchedIndices, float radius) const
     {
+        // one (possibly empty) list of neighbours per point, allocated from the same resource as the outer vector
+        matchedIndices.resize(centroids.size());
+
         float d = 0.0;
         for (int i = 0; i < centroids.size(); i++)
         {
@@ -207,7 +446,7 @@ namespace Detection
     }
 
     // Get enclosing bounding box that encloses all the given bounding boxes
-    cv::Rect FumaroleDetector::EnclosingBoundingBox(const std::vector<cv::Rect> &boxes) const
+    cv::Rect FumaroleDetector::EnclosingBoundingBox(const std::pmr::vector<cv::Rect> &boxes) const
     {
         auto minXIter = std::min_element(boxes.begin(), boxes.end(), [](const cv::Rect& r1, const cv::Rect& r2){ return r1.x < r2.x; });
         auto minYIter = std::min_element(boxes.begin(), boxes.end(), [](const cv::Rect& r1, const cv::Rect& r2){ return r1.y < r2.y; });
@@ -222,6 +461,11 @@ namespace Detection
         return cv::Rect(x, y, width, height);
     }
 
+    // Get run summary
+    const RunSummary& FumaroleDetector::GetRunSummary() const {
+        return m_Summary;
+    }
+
     // Save results as images with colors for different classes
     void FumaroleDetector::SaveResults(const Detection::FumaroleDetectionsPerImage &resultMap) const
     {
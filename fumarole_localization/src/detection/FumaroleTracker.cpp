@@ -0,0 +1,217 @@
+//
+// FumaroleTracker.cpp
+// Associates the detections of consecutive video frames into tracks with stable IDs
+//
+
+#include "detection/FumaroleTracker.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace Detection
+{
+    // Constructor
+    FumaroleTracker::FumaroleTracker(const Config::TrackingConfig& config) : m_Config(config)
+    {
+        m_Config.GateRadius = std::max(m_Config.GateRadius, std::numeric_limits<float>::epsilon());
+        m_Config.MaxMissedFrames = std::max(m_Config.MaxMissedFrames, 0);
+        m_Config.VelocitySmoothing = std::min(std::max(m_Config.VelocitySmoothing, 0.0f), 1.0f);
+    }
+
+    // Update
+    void FumaroleTracker::Update(const std::vector<FumaroleDetection>& detections, std::vector<uint64_t>& trackIDs)
+    {
+        m_Frame++;
+        m_Stats.Frames++;
+        m_Stats.Detections += detections.size();
+
+        BuildGrid();
+        FindCandidates(detections);
+
+        // greedy assignment, nearest pairs first (the gate keeps the pairs few, so this is close to optimal)
+        std::sort(m_Candidates.begin(), m_Candidates.end(), [](const Candidate& a, const Candidate& b) {
+            return a.Cost < b.Cost;
+        });
+
+        m_TrackDetection.assign(m_Tracks.size(), -1);
+        m_DetectionTrack.assign(detections.size(), -1);
+
+        for (const Candidate& candidate : m_Candidates)
+        {
+            if (m_TrackDetection[candidate.Track] >= 0 || m_DetectionTrack[candidate.Detection] >= 0) {
+                continue;
+            }
+
+            m_TrackDetection[candidate.Track] = static_cast<int>(candidate.Detection);
+            m_DetectionTrack[candidate.Detection] = static_cast<int>(candidate.Track);
+        }
+
+        // tracks without a detection coast on their velocity until they missed too many frames
+        size_t kept = 0;
+        for (size_t t = 0; t < m_Tracks.size(); t++)
+        {
+            FumaroleTrack& track = m_Tracks[t];
+
+            if (m_TrackDetection[t] >= 0) {
+                UpdateTrack(track, detections[m_TrackDetection[t]]);
+            }
+            else {
+                track.MissedFrames++;
+            }
+
+            if (track.MissedFrames > m_Config.MaxMissedFrames) {
+                m_Stats.TracksDropped++;
+                continue;
+            }
+
+            // compact the live tracks and point their detection at the new index
+            if (m_TrackDetection[t] >= 0) {
+                m_DetectionTrack[m_TrackDetection[t]] = static_cast<int>(kept);
+            }
+
+            if (kept != t) {
+                m_Tracks[kept] = track;
+            }
+
+            kept++;
+        }
+
+        m_Tracks.resize(kept);
+
+        // detections without a track start new ones
+        trackIDs.resize(detections.size());
+        for (size_t d = 0; d < detections.size(); d++)
+        {
+            if (m_DetectionTrack[d] < 0) {
+                StartTrack(detections[d]);
+                trackIDs[d] = m_Tracks.back().ID;
+            }
+            else {
+                trackIDs[d] = m_Tracks[m_DetectionTrack[d]].ID;
+            }
+        }
+    }
+
+    // Tracks
+    const std::vector<FumaroleTrack>& FumaroleTracker::GetTracks() const {
+        return m_Tracks;
+    }
+
+    // Stats
+    const TrackerStats& FumaroleTracker::GetStats() const {
+        return m_Stats;
+    }
+
+    // Reset
+    void FumaroleTracker::Reset()
+    {
+        m_Stats.TracksDropped += m_Tracks.size();
+        m_Tracks.clear();
+    }
+
+    // Cell of a pixel coordinate
+    int64_t FumaroleTracker::CellOf(float coordinate) const {
+        return static_cast<int64_t>(std::floor(coordinate / m_Config.GateRadius));
+    }
+
+    // Key of a cell
+    uint64_t FumaroleTracker::CellKey(int64_t cx, int64_t cy) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+    }
+
+    // Predict the position of each track in this frame and sort the tracks by the cell of the prediction
+    void FumaroleTracker::BuildGrid()
+    {
+        m_Predictions.resize(m_Tracks.size());
+        m_Grid.resize(m_Tracks.size());
+
+        for (size_t t = 0; t < m_Tracks.size(); t++)
+        {
+            const FumaroleTrack& track = m_Tracks[t];
+
+            // one frame of motion since the last update plus one for each missed frame
+            m_Predictions[t] = track.Position + track.Velocity * static_cast<float>(track.MissedFrames + 1);
+            m_Grid[t] = std::make_pair(CellKey(CellOf(m_Predictions[t].x), CellOf(m_Predictions[t].y)), static_cast<uint32_t>(t));
+        }
+
+        std::sort(m_Grid.begin(), m_Grid.end());
+    }
+
+    // Find the track and detection pairs of the same type within the gate radius
+    void FumaroleTracker::FindCandidates(const std::vector<FumaroleDetection>& detections)
+    {
+        m_Candidates.clear();
+
+        const float gate = m_Config.GateRadius * m_Config.GateRadius;
+
+        for (size_t d = 0; d < detections.size(); d++)
+        {
+            const cv::Point2f center = detections[d].Center();
+            const int64_t cx = CellOf(center.x);
+            const int64_t cy = CellOf(center.y);
+
+            // the cells are as large as the gate so only the neighbouring cells can hold a track within it
+            for (int64_t dy = -1; dy <= 1; dy++)
+            {
+                for (int64_t dx = -1; dx <= 1; dx++)
+                {
+                    const uint64_t key = CellKey(cx + dx, cy + dy);
+                    auto iter = std::lower_bound(m_Grid.begin(), m_Grid.end(), std::make_pair(key, static_cast<uint32_t>(0)));
+
+                    for (; iter != m_Grid.end() && iter->first == key; iter++)
+                    {
+                        const uint32_t t = iter->second;
+                        if (m_Tracks[t].Type != detections[d].Type) {
+                            continue;
+                        }
+
+                        const cv::Point2f delta = m_Predictions[t] - center;
+                        const float distance = delta.dot(delta);
+
+                        if (distance <= gate) {
+                            m_Candidates.push_back(Candidate { distance, t, static_cast<uint32_t>(d) });
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Start a track at a detection
+    void FumaroleTracker::StartTrack(const FumaroleDetection& detection)
+    {
+        FumaroleTrack track;
+        track.ID = m_NextID++;
+        track.Type = detection.Type;
+        track.Position = detection.Center();
+        track.BoundingBox = detection.BoundingBox;
+        track.Score = detection.Score;
+        track.Hits = 1;
+        track.FirstFrame = m_Frame;
+        track.LastFrame = m_Frame;
+
+        m_Tracks.push_back(track);
+        m_Stats.TracksStarted++;
+    }
+
+    // Move a track to its detection
+    void FumaroleTracker::UpdateTrack(FumaroleTrack& track, const FumaroleDetection& detection)
+    {
+        if (track.MissedFrames > 0) {
+            m_Stats.Redetections++;
+        }
+
+        // the motion per frame since the last detection, smoothed into the velocity
+        const cv::Point2f center = detection.Center();
+        const cv::Point2f motion = (center - track.Position) * (1.0f / static_cast<float>(m_Frame - track.LastFrame));
+        track.Velocity = track.Velocity * (1.0f - m_Config.VelocitySmoothing) + motion * m_Config.VelocitySmoothing;
+
+        track.Position = center;
+        track.BoundingBox = detection.BoundingBox;
+        track.Score = detection.Score;
+        track.Hits++;
+        track.MissedFrames = 0;
+        track.LastFrame = m_Frame;
+    }
+}
@@ -0,0 +1,229 @@
+//
+// WorldDeduplicator.cpp
+// Merges the detections of overlapping frames into one record per physical fumarole
+//
+
+#include "detection/WorldDeduplicator.hpp"
+
+#include <cmath>
+#include <limits>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+namespace Detection
+{
+    // weight of an observation without a score (e.g. a clustered detection of members without intensities)
+    const double MIN_OBSERVATION_WEIGHT { 0.01 };
+
+    // Map a pixel to world coordinates
+    static cv::Point2d ToWorld(const cv::Matx33d& homography, double x, double y)
+    {
+        const cv::Vec3d p = homography * cv::Vec3d(x, y, 1.0);
+        return cv::Point2d(p[0] / p[2], p[1] / p[2]);
+    }
+
+    // Constructor
+    WorldDeduplicator::WorldDeduplicator(double mergeRadius) : m_MergeRadius(std::max(mergeRadius, std::numeric_limits<double>::epsilon()))
+    {
+
+    }
+
+    // Add the detections of a frame
+    void WorldDeduplicator::AddFrame(const std::string& fileID, const cv::Matx33d& homography, const std::vector<FumaroleDetection>& detections)
+    {
+        const auto frame = static_cast<uint32_t>(m_FrameIDs.size());
+        m_FrameIDs.push_back(fileID);
+
+        for (const FumaroleDetection& detection : detections)
+        {
+            const cv::Rect& box = detection.BoundingBox;
+
+            // world position of the centre and world extent of the corners of the box
+            const cv::Point2d position = ToWorld(homography, box.x + box.width / 2.0, box.y + box.height / 2.0);
+            const cv::Point2d corners[] {
+                ToWorld(homography, box.x, box.y),
+                ToWorld(homography, box.x + box.width, box.y),
+                ToWorld(homography, box.x, box.y + box.height),
+                ToWorld(homography, box.x + box.width, box.y + box.height)
+            };
+
+            if (!std::isfinite(position.x) || !std::isfinite(position.y)) {
+                continue;
+            }
+
+            double minX = corners[0].x, maxX = corners[0].x;
+            double minY = corners[0].y, maxY = corners[0].y;
+            for (const cv::Point2d& corner : corners)
+            {
+                minX = std::min(minX, corner.x);
+                maxX = std::max(maxX, corner.x);
+                minY = std::min(minY, corner.y);
+                maxY = std::max(maxY, corner.y);
+            }
+
+            const cv::Rect2d extent(minX, minY, maxX - minX, maxY - minY);
+            const double weight = std::max(static_cast<double>(detection.Score), MIN_OBSERVATION_WEIGHT);
+
+            m_Observations++;
+
+            const long nearest = FindNearest(detection.Type, position, frame);
+            if (nearest < 0)
+            {
+                // a fumarole not observed before
+                WorldFeature feature;
+                feature.ID = m_Features.size() + 1;
+                feature.Type = detection.Type;
+                feature.Position = position;
+                feature.Extent = extent;
+                feature.MaxScore = detection.Score;
+                feature.Observations = 1;
+                feature.FirstFrame = frame;
+                feature.LastFrame = frame;
+                feature.Weight = weight;
+
+                m_Cells[CellKey(CellOf(position.x), CellOf(position.y))].push_back(static_cast<uint32_t>(m_Features.size()));
+                m_Features.push_back(feature);
+                continue;
+            }
+
+            WorldFeature& feature = m_Features[nearest];
+            const uint64_t oldKey = CellKey(CellOf(feature.Position.x), CellOf(feature.Position.y));
+
+            feature.Weight += weight;
+            feature.Position += (position - feature.Position) * (weight / feature.Weight);
+            feature.Extent |= extent;
+            feature.MaxScore = std::max(feature.MaxScore, detection.Score);
+            feature.Observations++;
+            feature.LastFrame = frame;
+
+            // the mean can move into a neighbouring cell
+            const uint64_t newKey = CellKey(CellOf(feature.Position.x), CellOf(feature.Position.y));
+            if (newKey != oldKey) {
+                MoveToCell(static_cast<size_t>(nearest), oldKey, newKey);
+            }
+        }
+    }
+
+    // Features
+    const std::vector<WorldFeature>& WorldDeduplicator::GetFeatures() const {
+        return m_Features;
+    }
+
+    // Frame ID
+    const std::string& WorldDeduplicator::GetFrameID(uint32_t frame) const {
+        return m_FrameIDs.at(frame);
+    }
+
+    // Observations
+    size_t WorldDeduplicator::GetObservationCount() const {
+        return m_Observations;
+    }
+
+    // Save to CSV
+    bool WorldDeduplicator::SaveToCSV(const std::string& filePath) const
+    {
+        std::ofstream fs(filePath, std::ios::out);
+        if (!fs.is_open()) {
+            std::cerr << "\nFailed to write " << filePath << std::endl;
+            return false;
+        }
+
+        // world coordinates need more digits than the default (e.g. UTM)
+        fs << std::fixed << std::setprecision(3);
+
+        // write header
+        fs << "feature_id,class_label,x,y,min_x,min_y,max_x,max_y,observations,max_score,first_frame,last_frame";
+
+        // write each feature as a record
+        for (const WorldFeature& f : m_Features)
+        {
+            fs << "\n";
+            fs << f.ID << ",";
+            fs << Model::TypeNameString(f.Type) << ",";
+            fs << f.Position.x << "," << f.Position.y << ",";
+            fs << f.Extent.x << "," << f.Extent.y << ",";
+            fs << f.Extent.x + f.Extent.width << "," << f.Extent.y + f.Extent.height << ",";
+            fs << f.Observations << ",";
+            fs << f.MaxScore << ",";
+            fs << m_FrameIDs[f.FirstFrame] << ",";
+            fs << m_FrameIDs[f.LastFrame];
+        }
+
+        return fs.good();
+    }
+
+    // Cell of a world coordinate
+    int64_t WorldDeduplicator::CellOf(double coordinate) const {
+        return static_cast<int64_t>(std::floor(coordinate / m_MergeRadius));
+    }
+
+    // Key of a cell (the cell coordinates are truncated to 32 bits, far cells may share a key which only costs a comparison)
+    uint64_t WorldDeduplicator::CellKey(int64_t cx, int64_t cy) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+    }
+
+    // Nearest feature of the type within the merge radius that was not observed in the frame yet
+    long WorldDeduplicator::FindNearest(Model::FumaroleType type, const cv::Point2d& position, uint32_t frame) const
+    {
+        const int64_t cx = CellOf(position.x);
+        const int64_t cy = CellOf(position.y);
+
+        long nearest = -1;
+        double nearestDistance = m_MergeRadius * m_MergeRadius;
+
+        // the cells are as large as the merge radius so only the neighbouring cells can hold a match
+        for (int64_t dy = -1; dy <= 1; dy++)
+        {
+            for (int64_t dx = -1; dx <= 1; dx++)
+            {
+                auto iter = m_Cells.find(CellKey(cx + dx, cy + dy));
+                if (iter == m_Cells.end()) {
+                    continue;
+                }
+
+                for (uint32_t index : iter->second)
+                {
+                    const WorldFeature& feature = m_Features[index];
+                    // a feature last observed in this frame is another fumarole of the same frame
+                    if (feature.Type != type || feature.LastFrame == frame) {
+                        continue;
+                    }
+
+                    const cv::Point2d delta = feature.Position - position;
+                    const double distance = delta.dot(delta);
+
+                    if (distance <= nearestDistance) {
+                        nearest = static_cast<long>(index);
+                        nearestDistance = distance;
+                    }
+                }
+            }
+        }
+
+        return nearest;
+    }
+
+    // Move a feature from one cell to another
+    void WorldDeduplicator::MoveToCell(size_t feature, uint64_t fromKey, uint64_t toKey)
+    {
+        auto iter = m_Cells.find(fromKey);
+        if (iter != m_Cells.end())
+        {
+            std::vector<uint32_t>& indices = iter->second;
+            auto position = std::find(indices.begin(), indices.end(), static_cast<uint32_t>(feature));
+            if (position != indices.end())
+            {
+                *position = indices.back();
+                indices.pop_back();
+            }
+
+            if (indices.empty()) {
+                m_Cells.erase(iter);
+            }
+        }
+
+        m_Cells[toKey].push_back(static_cast<uint32_t>(feature));
+    }
+}
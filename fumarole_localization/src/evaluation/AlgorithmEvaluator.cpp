@@ -9,23 +9,42 @@
 
 #include <algorithm>
 #include <numeric>
+#include <limits>
+#include <cmath>
 #include <iostream>
 #include <fstream>
 #include <eigen3/Eigen/Eigen>
 #include <opencv2/core/core.hpp>
+#include <opencv2/core/utility.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <boost/filesystem.hpp>
 
 namespace Evaluation
 {
-    AlgorithmEvaluator::AlgorithmEvaluator()
+    AlgorithmEvaluator::AlgorithmEvaluator() : AlgorithmEvaluator(Config::ConfigParser::GetInstance().GetDetectorConfig().Evaluation)
     {
-        // read in threshold params from XML file for evaluation
-        m_DetectionThresholdMin = Config::ConfigParser::GetInstance().GetValue<int>("config.evaluation.detection.threshold_min");
-        m_DetectionThresholdMax = Config::ConfigParser::GetInstance().GetValue<int>("config.evaluation.detection.threshold_max");
-        m_DetectionThresholdStep = Config::ConfigParser::GetInstance().GetValue<int>("config.evaluation.detection.threshold_step");
-        m_IoUThresholdStep = Config::ConfigParser::GetInstance().GetValue<float>("config.evaluation.detection.iou_threshold_step");
+
+    }
+
+    AlgorithmEvaluator::AlgorithmEvaluator(const Config::EvaluationConfig& config)
+    {
+        // threshold params for evaluation
+        m_DetectionThresholdMin = config.DetectionThresholdMin;
+        m_DetectionThresholdMax = config.DetectionThresholdMax;
+        m_DetectionThresholdStep = config.DetectionThresholdStep;
+        m_IoUThresholdStep = config.IoUThresholdStep;
+
+        // IoU thresholds are the multiples of the step from 0 to 1
+        m_IoUThresholdBins = std::max(1, static_cast<int>(std::lround(1.0 / m_IoUThresholdStep)));
+        m_IoUThresholdStep = 1.0f / static_cast<float>(m_IoUThresholdBins);
+
+        // matching of detections to the ground truth
+        m_AssignmentMethod = (config.MatchingMethod == "greedy" ? ASSIGNMENT_GREEDY : ASSIGNMENT_HUNGARIAN);
+        m_MinMatchIoU = config.MinMatchIoU;
+
+        // IoUs of the bounding boxes or of the (bit-packed) masks of the contours
+        m_IoUMode = (config.IoUMode == "mask" ? IOU_MASK : IOU_BOX);
     }
 
     AlgorithmEvaluator::~AlgorithmEvaluator()
@@ -38,56 +57,48 @@ namespace Evaluation
             const std::map<std::string, std::vector<Detection::FumaroleDetection>> &results,
             const std::map<std::string, std::vector<Detection::FumaroleDetection>> &truth) const
     {
-        AlgorithmEvaluation eval;
-        FumaroleDetectionEvaluation singleImageEval;
+        return AccumulateDetectionPipeline(results, truth).Finalize();
+    }
 
-        float totalIoU = 0.0;
+    // Evaluate the images in parallel
+    EvaluationAccumulator AlgorithmEvaluator::AccumulateDetectionPipeline(
+            const std::map<std::string, std::vector<Detection::FumaroleDetection>> &results,
+            const std::map<std::string, std::vector<Detection::FumaroleDetection>> &truth) const
+    {
+        EvaluationAccumulator total(m_IoUMode);
 
-        for (const auto& truthResult : truth)
+        // get corresponding detections from the pipeline
+        std::vector<std::pair<decltype(truth.begin()), decltype(results.begin())>> images;
+        for (auto truthIter = truth.begin(); truthIter != truth.end(); ++truthIter)
         {
-            eval.TotalNumberOfActualFumaroles += truthResult.second.size();
-
-            // get corresponding detection from the pipeline
-            auto iter = results.find(truthResult.first);
-            if (iter != results.end())
-            {
-                eval.TotalNumberDetected += iter->second.size();
-
-                // save the evaluation on this image
-                singleImageEval = EvaluateDetections(iter->second, truthResult.second);
-                singleImageEval.ImageID = truthResult.first;
-                eval.Evaluations.emplace_back(singleImageEval);
-
-                // accumulate total average IoU
-                totalIoU += singleImageEval.AverageIoU;
-
-                // accumulate total detection metrics
-                for (int t = m_DetectionThresholdMin; t <= m_DetectionThresholdMax; t += m_DetectionThresholdStep) {
-                    std::get<0>(eval.DetectionMetrics[t]) += std::get<0>(singleImageEval.DetectionMetrics[t]);
-                    std::get<1>(eval.DetectionMetrics[t]) += std::get<1>(singleImageEval.DetectionMetrics[t]);
-                }
-
-                // sum up confusion matrix for overall score
-                eval.ConfusionMatrix += singleImageEval.ConfusionMatrix;
+            auto iter = results.find(truthIter->first);
+            if (iter != results.end()) {
+                images.emplace_back(truthIter, iter);
+            }
+            else {
+                total.AddUnevaluatedImage(static_cast<int>(truthIter->second.size()));
             }
         }
 
-        // average the detection metrics for the IoUs
-        if (!eval.Evaluations.empty())
-        {
-            for (float t = 0.0; t <= 1.0; t += m_IoUThresholdStep)
+        // each image is evaluated into its own accumulator
+        std::vector<EvaluationAccumulator> accumulators(images.size(), EvaluationAccumulator(m_IoUMode));
+
+        cv::parallel_for_(cv::Range(0, static_cast<int>(images.size())), [&](const cv::Range& range) {
+            for (int i = range.start; i < range.end; i++)
             {
-                eval.IoUDetectionMetrics[t] = std::accumulate(eval.Evaluations.begin(), eval.Evaluations.end(), 0.0, [=](float total, Evaluation::FumaroleDetectionEvaluation &d) -> float {
-                    total += d.IoUMetrics[t];
-                    return total;
-                }) / static_cast<float>(eval.Evaluations.size());
+                FumaroleDetectionEvaluation singleImageEval = EvaluateDetections(images[i].second->second, images[i].first->second);
+                singleImageEval.ImageID = images[i].first->first;
+
+                accumulators[i].AddImage(singleImageEval, images[i].second->second, images[i].first->second);
             }
-        }
+        });
 
-        // total average IoU for whole algorithm considering all detections in all images
-        eval.TotalAverageIoU = totalIoU / static_cast<float>(eval.Evaluations.size());
+        // reduce in the order of the images
+        for (const EvaluationAccumulator& accumulator : accumulators) {
+            total.Merge(accumulator);
+        }
 
-        return std::move(eval);
+        return total;
     }
 
     // Evaluate single image results
@@ -98,35 +109,47 @@ namespace Evaluation
         eval.NumberDetected = results.size();
         eval.NumberOfActualFumaroles = truth.size();
 
-        // compute ious with each one in the ground truth dataset
-        std::vector<float> ious;
-        std::vector<float> correspondingIOUs;
+        // one-to-one matching of the detections to the ground truth (unmatched detections have an IoU of 0)
+        std::vector<size_t> resultIndices(results.size());
+        std::vector<size_t> truthIndices(truth.size());
+        std::iota(resultIndices.begin(), resultIndices.end(), 0);
+        std::iota(truthIndices.begin(), truthIndices.end(), 0);
 
-        for (const auto& x : results)
+        IoUMatrix iou;
+        MatchingEngine::ComputeIoUMatrix(results, resultIndices, truth, truthIndices, m_IoUMode, iou);
+
+        std::vector<int> assignment;
+        if (m_AssignmentMethod == ASSIGNMENT_GREEDY)
         {
-            for (const auto& y : truth) {
-                float iou = ComputeIoU(x.BoundingBox, y.BoundingBox);
-                ious.push_back(iou);
-            }
+            std::vector<float> scores(results.size());
+            std::transform(results.begin(), results.end(), scores.begin(), [](const Detection::FumaroleDetection& d) { return d.Score; });
+            assignment = MatchingEngine::GreedyAssignment(iou, scores, m_MinMatchIoU);
+        }
+        else {
+            assignment = MatchingEngine::HungarianAssignment(iou, m_MinMatchIoU);
+        }
 
-            // set the max iou from the list as the valid IOU
-            // ie; this was the corresponding rect to compare to in the ground truth set
-            auto maxIter = std::max_element(ious.begin(), ious.end());
-            correspondingIOUs.push_back(*maxIter);
+        std::vector<float> correspondingIOUs(results.size(), 0.0);
 
-            // detection evaluation
-            ComputeDetectionMetrics(results, truth, eval.DetectionMetrics);
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            if (assignment[i] < 0) {
+                continue;
+            }
 
-            // classification evaluation
-            size_t truthIndex = std::distance(ious.begin(), maxIter);
-            eval.ConfusionMatrix.AddClassifications(Model::TypeNameString(x.Type), Model::TypeNameString(truth[truthIndex].Type));
+            correspondingIOUs[i] = iou(i, assignment[i]);
 
-            // clear for matching next result
-            ious.clear();
+            // classification evaluation (only for detections that correspond to a ground truth fumarole)
+            eval.ConfusionMatrix.AddClassifications(results[i].Type, truth[assignment[i]].Type);
         }
 
+        // detection evaluation (once for all the results of the image)
+        ComputeDetectionMetrics(results, truth, eval.LocationErrorHistogram);
+        eval.DetectionMetrics = DetectionCurve(eval.LocationErrorHistogram);
+
         // Compute IoU metrics
-        ComputeIoUMetrics(correspondingIOUs, eval.IoUMetrics);
+        ComputeIoUMetrics(correspondingIOUs, eval.IoUHistogram);
+        eval.IoUMetrics = SuccessRateCurve(eval.IoUHistogram);
 
         float n = correspondingIOUs.size() > 0 ? static_cast<float>(correspondingIOUs.size()) : 1.0;
         eval.AverageIoU = std::accumulate(correspondingIOUs.begin(), correspondingIOUs.end(), 0.0) / n;
@@ -134,115 +157,63 @@ namespace Evaluation
         return eval;
     }
 
-    // Compute IoU of 2 rects
-    float AlgorithmEvaluator::ComputeIoU(const cv::Rect &r1, const cv::Rect &r2) const
-    {
-        cv::Rect intersectionRect = r1 & r2;
-        float intersectionArea = static_cast<float>(intersectionRect.area());
-
-        if (intersectionRect.area() > 0)
-        {
-            cv::Rect unionRect = r1 | r2;
-
-            float unionArea = static_cast<float>(unionRect.area());
-            float iou = intersectionArea / unionArea;
-
-            return iou;
-        }
-
-        return 0.0;
-    }
-
-    // Convert list of results to Eigen vectors
-    void AlgorithmEvaluator::ConvertResultsToEigenVectors(const std::vector<Detection::FumaroleDetection>& results, std::vector<Eigen::Vector4f> &vectors) const
-    {
-        for (const auto& r : results) {
-            vectors.emplace_back(Eigen::Vector4f(r.BoundingBox.x, r.BoundingBox.y, r.BoundingBox.x + r.BoundingBox.width, r.BoundingBox.y + r.BoundingBox.height));
-        }
-    }
-
     // Compute detection metrics for true positives and false positives by varying the location error threshold
     void AlgorithmEvaluator::ComputeDetectionMetrics(const std::vector<Detection::FumaroleDetection> &results,
                                                      const std::vector<Detection::FumaroleDetection>& groundTruth,
-                                                     std::map<int, std::tuple<int, int>> &metrics) const
+                                                     ThresholdHistogram& histogram) const
     {
         // convert to eigen matrix (library eigen - and not the mathematical concept of eigen vectors)
-        Eigen::MatrixX2f X = ConvertToCentroidEigenMatrix(results);
-        Eigen::MatrixX2f Y = ConvertToCentroidEigenMatrix(groundTruth);
+        Eigen::MatrixX2d X = ConvertToCentroidEigenMatrix(results);
+        Eigen::MatrixX2d Y = ConvertToCentroidEigenMatrix(groundTruth);
 
-        // counts
-        int truePositives = 0;
-        int falsePositives = 0;
-        int count = 0;
+        // distance of each detection to its nearest ground truth (no ground truth: every detection is a false positive)
+        std::vector<float> nearest(results.size(), std::numeric_limits<float>::infinity());
 
-        // run iterations based on threshold params and build up map of FP and TP
-        for (int t = m_DetectionThresholdMin; t <= m_DetectionThresholdMax; t += m_DetectionThresholdStep)
+        if (Y.rows() > 0)
         {
-            // reset counts for this threshold
-            truePositives = 0;
-            falsePositives = 0;
-
-            for (int i = 0; i < Y.rows(); i++)
-            {
-                // get l2 distances of Yi with each Xi
-                Eigen::VectorXf distances = (X.rowwise() - Y.row(i)).rowwise().norm();
-
-                // true positives are all detections that fall within the threshold
-                count = (distances.array() <= t).count();
-                truePositives = count;
-                falsePositives = results.size() - truePositives;
+            // the differences are taken directly (in double) so coincident centres are exactly 0 apart; expanding
+            // |x|^2 + |y|^2 - 2 x.y loses tenths of a pixel to cancellation at image coordinates
+            for (Eigen::Index i = 0; i < X.rows(); i++) {
+                nearest[i] = static_cast<float>(std::sqrt((Y.rowwise() - X.row(i)).rowwise().squaredNorm().minCoeff()));
             }
+        }
+
+        // each detection is a true positive from the first threshold its distance is within
+        const int thresholds = (m_DetectionThresholdMax - m_DetectionThresholdMin) / m_DetectionThresholdStep + 1;
+        histogram = ThresholdHistogram(static_cast<float>(m_DetectionThresholdMin), static_cast<float>(m_DetectionThresholdStep), thresholds);
 
-            std::get<0>(metrics[t]) = truePositives;
-            std::get<1>(metrics[t]) = falsePositives;
+        for (float distance : nearest) {
+            histogram.AddWithin(distance);
         }
     }
 
     // Compute IoU metrics against varying thresholds
-    void AlgorithmEvaluator::ComputeIoUMetrics(const std::vector<float>& iouScores, std::map<float, float> &metrics) const
+    void AlgorithmEvaluator::ComputeIoUMetrics(const std::vector<float>& iouScores, ThresholdHistogram& histogram) const
     {
-        // run threshold range
-        std::vector<float> validIoUs;
-        float successRate = 0.0;
-
-        for (float t = 0.0; t <= 1.0; t += m_IoUThresholdStep)
-        {
-            std::copy_if(iouScores.begin(), iouScores.end(), std::back_inserter(validIoUs), [=](const float iou) { return iou >= t; });
-            if (!iouScores.empty()) {
-                successRate = static_cast<float>(validIoUs.size()) / static_cast<float>(iouScores.size());
-            }
-
-            metrics[t] = successRate;
+        // each IoU is a success up to the last threshold it reaches
+        histogram = ThresholdHistogram(0.0, m_IoUThresholdStep, m_IoUThresholdBins + 1);
 
-            validIoUs.clear();
-            successRate = 0.0;
+        for (float iou : iouScores) {
+            histogram.AddReaching(iou);
         }
     }
 
     // Convert std::vector of detections to eigen matrix of centroids of detections
-    Eigen::MatrixX2f AlgorithmEvaluator::ConvertToCentroidEigenMatrix(const std::vector<Detection::FumaroleDetection> &detections) const
+    Eigen::MatrixX2d AlgorithmEvaluator::ConvertToCentroidEigenMatrix(const std::vector<Detection::FumaroleDetection> &detections) const
     {
-        Eigen::MatrixX2f matrix(detections.size(), 2);
+        Eigen::MatrixX2d matrix(detections.size(), 2);
         int row = 0;
 
         for (const Detection::FumaroleDetection& d : detections)
         {
-            matrix(row, 0) = d.Center().x;
-            matrix(row, 1) = d.Center().y;
+            // the centre of the box in double (as Center() but without rounding to float)
+            matrix(row, 0) = d.BoundingBox.x + d.BoundingBox.width / 2.0;
+            matrix(row, 1) = d.BoundingBox.y + d.BoundingBox.height / 2.0;
 
             row++;
         }
 
-        return std::move(matrix);
-    }
-
-    // Convert bounding boxes to centroid eigen vectors
-    void AlgorithmEvaluator::ConvertResultsToEigenVectors(const std::vector<Detection::FumaroleDetection> &results,
-                                                          std::vector<Eigen::Vector2f> &vectors) const
-    {
-        for (const Detection::FumaroleDetection& d : results) {
-            vectors.emplace_back(Eigen::Vector2f(d.Center().x, d.Center().y));
-        }
+        return matrix;
     }
 
     // Save metrics to CSV file
@@ -287,6 +258,34 @@ namespace Evaluation
         fs.close();
     }
 
+    // Save precision recall curves to CSV
+    void AlgorithmEvaluator::SavePrecisionRecallCurvesToCSV(const std::string& folder, const MatchEvaluation& matching)
+    {
+        for (const auto& c : matching.Classes)
+        {
+            std::ofstream fs;
+            fs.open(folder + Model::TypeNameString(c.first) + "_pr_curve.csv", std::ios::out);
+
+            // write header
+            fs << "Recall";
+            for (const PrecisionRecallCurve& curve : c.second.Curves) {
+                fs << ",Precision@" << curve.IoUThreshold;
+            }
+
+            // one row per recall level
+            const size_t levels = c.second.Curves.empty() ? 0 : c.second.Curves.front().Precision.size();
+            for (size_t r = 0; r < levels; r++)
+            {
+                fs << "\n" << static_cast<float>(r) / static_cast<float>(levels - 1);
+                for (const PrecisionRecallCurve& curve : c.second.Curves) {
+                    fs << "," << curve.Precision[r];
+                }
+            }
+
+            fs.close();
+        }
+    }
+
     // Draw bounding boxes of both detection and ground truths for comparison
     void AlgorithmEvaluator::DrawDetectionsVsGroundtruth(const std::string& fileID,
                                                          const std::string& folder,
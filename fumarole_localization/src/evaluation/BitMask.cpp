@@ -0,0 +1,161 @@
+//
+// BitMask.cpp
+// Bit-packed raster of a detection for computing mask IoUs
+//
+
+#include "evaluation/BitMask.hpp"
+
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+namespace Evaluation
+{
+    // Index of the word holding image column x (rounded down for negative x)
+    static int WordOf(int x, int bits)
+    {
+        return (x >= 0 ? x / bits : -((-x + bits - 1) / bits));
+    }
+
+    // Rasterize a detection
+    BitMask::BitMask(const Detection::FumaroleDetection& detection)
+    {
+        // ground truth and clustered detections only have a bounding box
+        if (detection.Contour.empty())
+        {
+            Allocate(detection.BoundingBox);
+            for (int y = m_Bounds.y; y < m_Bounds.y + m_Bounds.height; y++) {
+                SetRun(y, m_Bounds.x, m_Bounds.x + m_Bounds.width);
+            }
+
+            return;
+        }
+
+        Allocate(cv::boundingRect(detection.Contour));
+        if (m_Words.empty()) {
+            return;
+        }
+
+        // fill the contour over its bounding box and pack the runs of set pixels
+        const cv::Point* polygon = detection.Contour.data();
+        const int length = static_cast<int>(detection.Contour.size());
+
+        cv::Mat raster = cv::Mat::zeros(m_Bounds.height, m_Bounds.width, CV_8U);
+        cv::fillPoly(raster, &polygon, &length, 1, cv::Scalar(255), cv::LINE_8, 0, -m_Bounds.tl());
+
+        for (int r = 0; r < raster.rows; r++)
+        {
+            const uchar* pixels = raster.ptr<uchar>(r);
+
+            int c = 0;
+            while (c < raster.cols)
+            {
+                while (c < raster.cols && pixels[c] == 0) {
+                    c++;
+                }
+
+                const int start = c;
+                while (c < raster.cols && pixels[c] != 0) {
+                    c++;
+                }
+
+                if (c > start) {
+                    SetRun(m_Bounds.y + r, m_Bounds.x + start, m_Bounds.x + c);
+                }
+            }
+        }
+    }
+
+    // Rasterize detections
+    std::vector<BitMask> BitMask::Rasterize(const std::vector<Detection::FumaroleDetection>& detections, const std::vector<size_t>& indices)
+    {
+        std::vector<BitMask> masks;
+        masks.reserve(indices.size());
+
+        for (size_t index : indices) {
+            masks.emplace_back(detections[index]);
+        }
+
+        return masks;
+    }
+
+    // Intersection area
+    int BitMask::IntersectionArea(const BitMask& a, const BitMask& b)
+    {
+        // only the rows and words both masks cover
+        const int y0 = std::max(a.m_Bounds.y, b.m_Bounds.y);
+        const int y1 = std::min(a.m_Bounds.y + a.m_Bounds.height, b.m_Bounds.y + b.m_Bounds.height);
+        const int w0 = std::max(a.m_FirstWord, b.m_FirstWord);
+        const int w1 = std::min(a.m_FirstWord + a.m_WordsPerRow, b.m_FirstWord + b.m_WordsPerRow);
+
+        if (a.m_Words.empty() || b.m_Words.empty() || y0 >= y1 || w0 >= w1) {
+            return 0;
+        }
+
+        int area = 0;
+        for (int y = y0; y < y1; y++)
+        {
+            const uint64_t* rowA = a.Row(y) + (w0 - a.m_FirstWord);
+            const uint64_t* rowB = b.Row(y) + (w0 - b.m_FirstWord);
+
+            for (int w = 0; w < w1 - w0; w++) {
+                area += __builtin_popcountll(rowA[w] & rowB[w]);
+            }
+        }
+
+        return area;
+    }
+
+    // IoU
+    float BitMask::IoU(const BitMask& a, const BitMask& b)
+    {
+        // masks with disjoint bounds do not need to be compared
+        if ((a.m_Bounds & b.m_Bounds).area() == 0) {
+            return 0.0;
+        }
+
+        const int intersection = IntersectionArea(a, b);
+        const int unionArea = a.m_Area + b.m_Area - intersection;
+
+        return (unionArea > 0 ? static_cast<float>(intersection) / static_cast<float>(unionArea) : 0.0f);
+    }
+
+    // Allocate the words for the bounds
+    void BitMask::Allocate(const cv::Rect& bounds)
+    {
+        m_Bounds = bounds;
+        m_Area = 0;
+        m_Words.clear();
+
+        if (bounds.width <= 0 || bounds.height <= 0) {
+            m_Bounds = cv::Rect();
+            m_FirstWord = 0;
+            m_WordsPerRow = 0;
+            return;
+        }
+
+        m_FirstWord = WordOf(bounds.x, WORD_BITS);
+        m_WordsPerRow = WordOf(bounds.x + bounds.width - 1, WORD_BITS) - m_FirstWord + 1;
+        m_Words.assign(static_cast<size_t>(bounds.height) * m_WordsPerRow, 0);
+    }
+
+    // Set the pixels [x0, x1) of row y
+    void BitMask::SetRun(int y, int x0, int x1)
+    {
+        uint64_t* row = m_Words.data() + static_cast<size_t>(y - m_Bounds.y) * m_WordsPerRow;
+        m_Area += x1 - x0;
+
+        int x = x0;
+        while (x < x1)
+        {
+            const int word = WordOf(x, WORD_BITS);
+            const int bit = x - word * WORD_BITS;
+            const int count = std::min(WORD_BITS - bit, x1 - x);
+
+            const uint64_t bits = (count == WORD_BITS ? ~uint64_t(0) : ((uint64_t(1) << count) - 1) << bit);
+            row[word - m_FirstWord] |= bits;
+
+            x += count;
+        }
+    }
+}
@@ -5,93 +5,54 @@
 
 #include "evaluation/ConfusionMatrix.hpp"
 
-#include <algorithm>
-
-#ifdef __APPLE__
-    #include <eigen3/Eigen/Dense>
-#else
-    #include <Eigen/Dense>
-#endif
+#include <numeric>
+#include <type_traits>
 
 namespace Evaluation
 {
-    // Constructor
-    ConfusionMatrix::ConfusionMatrix(const std::vector<std::string> &classLabels) : m_ClassLabels(classLabels), m_Matrix(classLabels.size(), classLabels.size())
-    {
-        // initialise matrix
-        for (size_t i = 0; i < m_ClassLabels.size(); i++)
-        {
-            for (size_t j = 0; j < m_ClassLabels.size(); j++) {
-                m_Matrix(i, j) = 0;
-            }
-        }
-    }
-
-    // Destructor
-    ConfusionMatrix::~ConfusionMatrix() = default;
-
-    void ConfusionMatrix::AddClassifications(const std::string &predictedClass, const std::string &actualClass, int count)
-    {
-        int x = IndexOfClass(predictedClass);
-        int y = IndexOfClass(actualClass);
-
-        m_Matrix(y, x) = m_Matrix(y, x) + count;
-    }
-
-    // Get the index of class label
-    int ConfusionMatrix::IndexOfClass(const std::string& classLabel) const
-    {
-        auto iter = std::find(m_ClassLabels.begin(), m_ClassLabels.end(), classLabel);
-        if (iter != m_ClassLabels.end()) {
-            return static_cast<int>(std::distance(m_ClassLabels.begin(), iter));
-        }
-        else {
-            return -1;
-        }
-    }
+    static_assert(std::is_trivially_copyable<ConfusionMatrix>::value, "ConfusionMatrix is copied and merged as plain counts");
 
     // Precision
-    float ConfusionMatrix::GetPrecision(const std::string& classLabel) const
+    float ConfusionMatrix::GetPrecision(Model::FumaroleType type) const
     {
-        int index = IndexOfClass(classLabel);
-        if (index < 0) {
-            return 0.0;
+        // all the classifications predicted as the class
+        float total = 0.0;
+        for (int actual = 0; actual < NUMBER_OF_CLASSES; actual++) {
+            total += static_cast<float>(Count(actual, type));
         }
 
-        float truePositives = m_Matrix(index, index);
-        float total = m_Matrix.colwise().sum()(0);
-
         if (total == 0.0) {
-            total = 1.0;
+            return 0.0;
         }
 
-        return (truePositives / total);
+        return static_cast<float>(Count(type, type)) / total;
     }
 
     // Recall
-    float ConfusionMatrix::GetRecall(const std::string &classLabel) const
+    float ConfusionMatrix::GetRecall(Model::FumaroleType type) const
     {
-        int index = IndexOfClass(classLabel);
-        if (index < 0) {
-            return 0.0;
+        // all the classifications of fumaroles of the class
+        float total = 0.0;
+        for (int predicted = 0; predicted < NUMBER_OF_CLASSES; predicted++) {
+            total += static_cast<float>(Count(type, predicted));
         }
 
-        float truePositives = m_Matrix(index, index);
-
-        float total = m_Matrix.rowwise().sum()(0);
         if (total == 0.0) {
-            total = 1.0;
+            return 0.0;
         }
 
-        return (truePositives / total);
+        return static_cast<float>(Count(type, type)) / total;
     }
 
     // Accuracy
     float ConfusionMatrix::GetAccuracy() const
     {
-        float correct = m_Matrix.diagonal().sum();
-        float total = m_Matrix.sum();
+        float correct = 0.0;
+        for (int i = 0; i < NUMBER_OF_CLASSES; i++) {
+            correct += static_cast<float>(Count(i, i));
+        }
 
+        float total = static_cast<float>(std::accumulate(m_Counts.begin(), m_Counts.end(), 0));
         if (total == 0) {
             total = 1.0;
         }
@@ -102,25 +63,27 @@ namespace Evaluation
     // Output stream
     std::ostream& operator<<(std::ostream& os, const ConfusionMatrix& cm)
     {
+        const int n = ConfusionMatrix::NUMBER_OF_CLASSES;
+
         // output headers
         os << ",";
-        for (size_t i = 0; i < cm.m_ClassLabels.size(); i++)
+        for (int i = 0; i < n; i++)
         {
-            os << cm.m_ClassLabels[i];
-            if (i < cm.m_ClassLabels.size() - 1) {
+            os << Model::TypeNameString(static_cast<Model::FumaroleType>(i));
+            if (i < n - 1) {
                 os << ",";
             }
         }
         os << std::endl;
 
         // output confusion matrix
-        for (int i = 0; i < cm.m_ClassLabels.size(); i++)
+        for (int i = 0; i < n; i++)
         {
-            os << cm.m_ClassLabels[i] << ",";
-            for (int j = 0; j < cm.m_ClassLabels.size(); j++)
+            os << Model::TypeNameString(static_cast<Model::FumaroleType>(i)) << ",";
+            for (int j = 0; j < n; j++)
             {
-                os << cm.m_Matrix(i, j);
-                if (j < cm.m_ClassLabels.size() - 1) {
+                os << cm.Count(i, j);
+                if (j < n - 1) {
                     os << ",";
                 }
             }
@@ -131,8 +94,36 @@ namespace Evaluation
     }
 
     // Append other confusion matrix data
-    ConfusionMatrix& ConfusionMatrix::operator+=(const Evaluation::ConfusionMatrix &other) {
-        this->m_Matrix += other.m_Matrix;
+    ConfusionMatrix& ConfusionMatrix::operator+=(const ConfusionMatrix& other)
+    {
+        for (size_t i = 0; i < m_Counts.size(); i++) {
+            m_Counts[i] += other.m_Counts[i];
+        }
+
         return *this;
     }
+
+    // Write counts
+    void ConfusionMatrix::Write(std::ostream& os) const
+    {
+        os << NUMBER_OF_CLASSES;
+        for (int count : m_Counts) {
+            os << " " << count;
+        }
+    }
+
+    // Read counts
+    bool ConfusionMatrix::Read(std::istream& is)
+    {
+        int size = 0;
+        if (!(is >> size) || size != NUMBER_OF_CLASSES) {
+            return false;
+        }
+
+        for (int& count : m_Counts) {
+            is >> count;
+        }
+
+        return static_cast<bool>(is);
+    }
 }
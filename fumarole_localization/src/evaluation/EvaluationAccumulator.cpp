@@ -0,0 +1,195 @@
+//
+// EvaluationAccumulator.cpp
+// Mergeable evaluation state of a set of images
+//
+
+#include "evaluation/EvaluationAccumulator.hpp"
+
+#include <limits>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace Evaluation
+{
+    const std::string SHARD_HEADER { "fumarole_evaluation_shard" };
+    const int SHARD_FORMAT_VERSION { 3 };
+
+    // Constructor
+    EvaluationAccumulator::EvaluationAccumulator(IoUMode mode) : m_Matching(mode)
+    {
+
+    }
+
+    // Add image
+    void EvaluationAccumulator::AddImage(const FumaroleDetectionEvaluation& evaluation,
+                                         const std::vector<Detection::FumaroleDetection>& results,
+                                         const std::vector<Detection::FumaroleDetection>& truth)
+    {
+        m_TotalNumberOfActualFumaroles += static_cast<int>(truth.size());
+        m_Evaluations[evaluation.ImageID] = evaluation;
+        m_Matching.AddImage(results, truth);
+    }
+
+    // Add image without results
+    void EvaluationAccumulator::AddUnevaluatedImage(int numberOfActualFumaroles) {
+        m_TotalNumberOfActualFumaroles += numberOfActualFumaroles;
+    }
+
+    // Merge
+    bool EvaluationAccumulator::Merge(const EvaluationAccumulator& other)
+    {
+        bool disjoint = true;
+
+        for (const auto& e : other.m_Evaluations)
+        {
+            if (!m_Evaluations.emplace(e.first, e.second).second)
+            {
+                std::cerr << "\nImage " << e.first << " was evaluated more than once, skipping" << std::endl;
+                disjoint = false;
+            }
+        }
+
+        m_TotalNumberOfActualFumaroles += other.m_TotalNumberOfActualFumaroles;
+        m_Matching.Merge(other.m_Matching);
+
+        return disjoint;
+    }
+
+    // Finalize
+    AlgorithmEvaluation EvaluationAccumulator::Finalize() const
+    {
+        AlgorithmEvaluation eval;
+        eval.TotalNumberOfActualFumaroles = m_TotalNumberOfActualFumaroles;
+
+        float totalIoU = 0.0;
+
+        for (const auto& e : m_Evaluations)
+        {
+            const FumaroleDetectionEvaluation& singleImageEval = e.second;
+
+            eval.TotalNumberDetected += singleImageEval.NumberDetected;
+            eval.Evaluations.emplace_back(singleImageEval);
+
+            // accumulate total average IoU
+            totalIoU += singleImageEval.AverageIoU;
+
+            // sum up the histograms (bin by bin)
+            eval.LocationErrorHistogram += singleImageEval.LocationErrorHistogram;
+            eval.IoUHistogram += singleImageEval.IoUHistogram;
+
+            // sum up confusion matrix for overall score
+            eval.ConfusionMatrix += singleImageEval.ConfusionMatrix;
+        }
+
+        // curves of all the detections
+        eval.DetectionMetrics = DetectionCurve(eval.LocationErrorHistogram);
+        eval.IoUDetectionMetrics = SuccessRateCurve(eval.IoUHistogram);
+
+        // total average IoU for whole algorithm considering all detections in all images
+        if (!eval.Evaluations.empty()) {
+            eval.TotalAverageIoU = totalIoU / static_cast<float>(eval.Evaluations.size());
+        }
+
+        // precision recall curves and mAP over all images
+        eval.Matching = m_Matching.Evaluate();
+
+        return eval;
+    }
+
+    // Save
+    bool EvaluationAccumulator::Save(const std::string& filePath) const
+    {
+        std::ofstream fs(filePath, std::ios::out | std::ios::trunc);
+        if (!fs.is_open()) {
+            std::cerr << "\nFailed to write evaluation shard: " << filePath << std::endl;
+            return false;
+        }
+
+        // floats are written with enough digits to be read back exactly
+        fs << std::setprecision(std::numeric_limits<float>::max_digits10);
+        fs << SHARD_HEADER << " " << SHARD_FORMAT_VERSION << "\n";
+        fs << m_TotalNumberOfActualFumaroles << " " << m_Evaluations.size() << "\n";
+
+        for (const auto& e : m_Evaluations)
+        {
+            const FumaroleDetectionEvaluation& eval = e.second;
+
+            fs << std::quoted(eval.ImageID) << " " << eval.NumberOfActualFumaroles << " " << eval.NumberDetected << " " << eval.AverageIoU << " ";
+            eval.ConfusionMatrix.Write(fs);
+
+            fs << " ";
+            eval.LocationErrorHistogram.Write(fs);
+            fs << " ";
+            eval.IoUHistogram.Write(fs);
+
+            fs << "\n";
+        }
+
+        m_Matching.Write(fs);
+        fs << "\n";
+
+        fs.close();
+        if (!fs) {
+            std::cerr << "\nFailed to write evaluation shard: " << filePath << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Load
+    bool EvaluationAccumulator::Load(const std::string& filePath)
+    {
+        std::ifstream fs(filePath, std::ios::in);
+        if (!fs.is_open()) {
+            std::cerr << "\nFailed to open evaluation shard: " << filePath << std::endl;
+            return false;
+        }
+
+        std::string header;
+        int version = 0;
+        fs >> header >> version;
+        if (header != SHARD_HEADER || version != SHARD_FORMAT_VERSION) {
+            std::cerr << "\nNot an evaluation shard (or an unsupported version): " << filePath << std::endl;
+            return false;
+        }
+
+        // read into temporaries so a corrupt shard leaves the accumulator unchanged
+        std::map<std::string, FumaroleDetectionEvaluation> evaluations;
+        int totalNumberOfActualFumaroles = 0;
+
+        size_t count = 0;
+        fs >> totalNumberOfActualFumaroles >> count;
+
+        for (size_t i = 0; i < count && fs; i++)
+        {
+            FumaroleDetectionEvaluation eval;
+
+            fs >> std::quoted(eval.ImageID) >> eval.NumberOfActualFumaroles >> eval.NumberDetected >> eval.AverageIoU;
+            if (!eval.ConfusionMatrix.Read(fs)) {
+                break;
+            }
+
+            if (!eval.LocationErrorHistogram.Read(fs) || !eval.IoUHistogram.Read(fs)) {
+                break;
+            }
+
+            eval.DetectionMetrics = DetectionCurve(eval.LocationErrorHistogram);
+            eval.IoUMetrics = SuccessRateCurve(eval.IoUHistogram);
+
+            evaluations[eval.ImageID] = std::move(eval);
+        }
+
+        // the matching is read last and only replaced if it is valid
+        if (!fs || evaluations.size() != count || !m_Matching.Read(fs)) {
+            std::cerr << "\nFailed to read evaluation shard: " << filePath << std::endl;
+            return false;
+        }
+
+        m_TotalNumberOfActualFumaroles = totalNumberOfActualFumaroles;
+        m_Evaluations = std::move(evaluations);
+
+        return true;
+    }
+}
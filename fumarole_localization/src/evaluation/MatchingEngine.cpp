@@ -0,0 +1,468 @@
+//
+// MatchingEngine.cpp
+// One-to-one matching of detections to ground truth and COCO-style mean average precision
+//
+
+#include "evaluation/MatchingEngine.hpp"
+
+#include <limits>
+#include <numeric>
+#include <algorithm>
+
+namespace Evaluation
+{
+    const int RECALL_LEVELS { 101 };
+    const std::vector<Model::FumaroleType> MATCHED_TYPES {
+        Model::FumaroleType::FUMAROLE_HOLE,
+        Model::FumaroleType::FUMAROLE_OPEN_VENT,
+        Model::FumaroleType::FUMAROLE_HIDDEN_VENT,
+        Model::FumaroleType::FUMAROLE_HEATED_AREA
+    };
+
+    // Box array from detections
+    BoxArray::BoxArray(const std::vector<Detection::FumaroleDetection>& detections)
+    {
+        std::vector<size_t> indices(detections.size());
+        std::iota(indices.begin(), indices.end(), 0);
+
+        *this = BoxArray(detections, indices);
+    }
+
+    // Box array from some of the detections
+    BoxArray::BoxArray(const std::vector<Detection::FumaroleDetection>& detections, const std::vector<size_t>& indices)
+    {
+        const Eigen::Index n = static_cast<Eigen::Index>(indices.size());
+        X1.resize(n);
+        Y1.resize(n);
+        X2.resize(n);
+        Y2.resize(n);
+
+        for (Eigen::Index i = 0; i < n; i++)
+        {
+            const cv::Rect& r = detections[indices[i]].BoundingBox;
+            X1(i) = static_cast<float>(r.x);
+            Y1(i) = static_cast<float>(r.y);
+            X2(i) = static_cast<float>(r.x + r.width);
+            Y2(i) = static_cast<float>(r.y + r.height);
+        }
+
+        Area = (X2 - X1) * (Y2 - Y1);
+    }
+
+    // Constructor
+    MatchingEngine::MatchingEngine(IoUMode mode) : m_IoUMode(mode)
+    {
+        for (int i = 0; i < 10; i++) {
+            m_IoUThresholds.push_back(0.5f + 0.05f * static_cast<float>(i));
+        }
+    }
+
+    // Match the detections of an image per class and record them
+    void MatchingEngine::AddImage(const std::vector<Detection::FumaroleDetection>& results, const std::vector<Detection::FumaroleDetection>& truth)
+    {
+        std::vector<size_t> resultIndices;
+        std::vector<size_t> truthIndices;
+        std::vector<float> scores;
+        IoUMatrix iou;
+
+        for (Model::FumaroleType type : MATCHED_TYPES)
+        {
+            resultIndices.clear();
+            truthIndices.clear();
+            scores.clear();
+
+            for (size_t i = 0; i < results.size(); i++)
+            {
+                if (results[i].Type == type) {
+                    resultIndices.push_back(i);
+                    scores.push_back(results[i].Score);
+                }
+            }
+
+            for (size_t i = 0; i < truth.size(); i++) {
+                if (truth[i].Type == type) {
+                    truthIndices.push_back(i);
+                }
+            }
+
+            m_TruthCounts[type] += static_cast<int>(truthIndices.size());
+            if (resultIndices.empty()) {
+                continue;
+            }
+
+            // the IoU matrix is computed once and matched at every threshold
+            ComputeIoUMatrix(results, resultIndices, truth, truthIndices, m_IoUMode, iou);
+
+            std::vector<MatchRecord> records(resultIndices.size());
+            for (size_t i = 0; i < records.size(); i++) {
+                records[i] = { scores[i], 0 };
+            }
+
+            for (size_t t = 0; t < m_IoUThresholds.size(); t++)
+            {
+                std::vector<int> assignment = GreedyAssignment(iou, scores, m_IoUThresholds[t]);
+                for (size_t i = 0; i < assignment.size(); i++) {
+                    if (assignment[i] >= 0) {
+                        records[i].TruePositives |= (1u << t);
+                    }
+                }
+            }
+
+            std::vector<MatchRecord>& classRecords = m_Records[type];
+            classRecords.insert(classRecords.end(), records.begin(), records.end());
+        }
+    }
+
+    // Precision recall curves and mAP
+    MatchEvaluation MatchingEngine::Evaluate() const
+    {
+        MatchEvaluation evaluation;
+
+        for (const auto& truthCount : m_TruthCounts)
+        {
+            // AP is undefined for classes without ground truth
+            if (truthCount.second == 0) {
+                continue;
+            }
+
+            ClassMatchEvaluation classEvaluation;
+            classEvaluation.NumberOfActualFumaroles = truthCount.second;
+
+            // detections of all images ranked by score
+            // equal scores are ranked by their matches (false positives first) so the ranking does not depend on the order of the images
+            std::vector<MatchRecord> records;
+            auto iter = m_Records.find(truthCount.first);
+            if (iter != m_Records.end()) {
+                records = iter->second;
+            }
+            std::sort(records.begin(), records.end(), [](const MatchRecord& r1, const MatchRecord& r2) {
+                return (r1.Score != r2.Score ? r1.Score > r2.Score : r1.TruePositives < r2.TruePositives);
+            });
+
+            classEvaluation.NumberDetected = static_cast<int>(records.size());
+
+            std::vector<float> precision(records.size());
+            std::vector<float> recall(records.size());
+
+            for (size_t t = 0; t < m_IoUThresholds.size(); t++)
+            {
+                int truePositives = 0;
+                for (size_t i = 0; i < records.size(); i++)
+                {
+                    truePositives += (records[i].TruePositives >> t) & 1u;
+                    precision[i] = static_cast<float>(truePositives) / static_cast<float>(i + 1);
+                    recall[i] = static_cast<float>(truePositives) / static_cast<float>(truthCount.second);
+                }
+
+                // precision envelope (max precision at any higher recall)
+                for (size_t i = records.size(); i-- > 1;) {
+                    precision[i - 1] = std::max(precision[i - 1], precision[i]);
+                }
+
+                PrecisionRecallCurve curve;
+                curve.IoUThreshold = m_IoUThresholds[t];
+                curve.Precision.assign(RECALL_LEVELS, 0.0);
+
+                // precision at the first rank that reaches each recall level
+                size_t rank = 0;
+                for (int r = 0; r < RECALL_LEVELS; r++)
+                {
+                    const float level = static_cast<float>(r) / static_cast<float>(RECALL_LEVELS - 1);
+                    while (rank < recall.size() && recall[rank] < level) {
+                        rank++;
+                    }
+
+                    if (rank == recall.size()) {
+                        break;
+                    }
+
+                    curve.Precision[r] = precision[rank];
+                }
+
+                curve.AveragePrecision = std::accumulate(curve.Precision.begin(), curve.Precision.end(), 0.0f) / static_cast<float>(RECALL_LEVELS);
+                classEvaluation.Curves.emplace_back(std::move(curve));
+            }
+
+            classEvaluation.AveragePrecision = std::accumulate(classEvaluation.Curves.begin(), classEvaluation.Curves.end(), 0.0f, [](float total, const PrecisionRecallCurve& c) {
+                return total + c.AveragePrecision;
+            }) / static_cast<float>(classEvaluation.Curves.size());
+
+            evaluation.Classes[truthCount.first] = std::move(classEvaluation);
+        }
+
+        // mean over the classes
+        if (!evaluation.Classes.empty())
+        {
+            for (const auto& c : evaluation.Classes)
+            {
+                evaluation.MeanAveragePrecision += c.second.AveragePrecision;
+                evaluation.MeanAveragePrecision50 += c.second.Curves[0].AveragePrecision;
+                evaluation.MeanAveragePrecision75 += c.second.Curves[5].AveragePrecision;
+            }
+
+            const float n = static_cast<float>(evaluation.Classes.size());
+            evaluation.MeanAveragePrecision /= n;
+            evaluation.MeanAveragePrecision50 /= n;
+            evaluation.MeanAveragePrecision75 /= n;
+        }
+
+        return evaluation;
+    }
+
+    // Merge
+    void MatchingEngine::Merge(const MatchingEngine& other)
+    {
+        for (const auto& truthCount : other.m_TruthCounts) {
+            m_TruthCounts[truthCount.first] += truthCount.second;
+        }
+
+        for (const auto& records : other.m_Records)
+        {
+            std::vector<MatchRecord>& classRecords = m_Records[records.first];
+            classRecords.insert(classRecords.end(), records.second.begin(), records.second.end());
+        }
+    }
+
+    // Write
+    void MatchingEngine::Write(std::ostream& os) const
+    {
+        const std::streamsize precision = os.precision(std::numeric_limits<float>::max_digits10);
+
+        os << m_TruthCounts.size();
+        for (const auto& truthCount : m_TruthCounts) {
+            os << " " << static_cast<int>(truthCount.first) << " " << truthCount.second;
+        }
+
+        os << " " << m_Records.size();
+        for (const auto& records : m_Records)
+        {
+            os << " " << static_cast<int>(records.first) << " " << records.second.size();
+            for (const MatchRecord& r : records.second) {
+                os << " " << r.Score << " " << r.TruePositives;
+            }
+        }
+
+        os.precision(precision);
+    }
+
+    // Read
+    bool MatchingEngine::Read(std::istream& is)
+    {
+        // read into temporaries so a corrupt shard leaves the engine unchanged
+        std::map<Model::FumaroleType, int> truthCounts;
+        std::map<Model::FumaroleType, std::vector<MatchRecord>> records;
+
+        size_t count = 0;
+        size_t length = 0;
+        int type = 0;
+
+        is >> count;
+        for (size_t i = 0; i < count && is; i++)
+        {
+            if (!(is >> type) || type < 0 || type > Model::UNKNOWN) {
+                return false;
+            }
+
+            is >> truthCounts[static_cast<Model::FumaroleType>(type)];
+        }
+
+        is >> count;
+        for (size_t i = 0; i < count && is; i++)
+        {
+            if (!(is >> type >> length) || type < 0 || type > Model::UNKNOWN) {
+                return false;
+            }
+
+            // the records are appended as they are read (not sized from the untrusted length)
+            std::vector<MatchRecord>& typeRecords = records[static_cast<Model::FumaroleType>(type)];
+            MatchRecord r;
+            for (size_t j = 0; j < length && is >> r.Score >> r.TruePositives; j++) {
+                typeRecords.push_back(r);
+            }
+        }
+
+        if (!is) {
+            return false;
+        }
+
+        m_TruthCounts = std::move(truthCounts);
+        m_Records = std::move(records);
+
+        return true;
+    }
+
+    // IoU of all pairs
+    void MatchingEngine::ComputeIoUMatrix(const BoxArray& a, const BoxArray& b, IoUMatrix& iou)
+    {
+        iou.resize(a.Size(), b.Size());
+        if (b.Size() == 0) {
+            return;
+        }
+
+        Eigen::ArrayXf width(b.Size());
+        Eigen::ArrayXf height(b.Size());
+        Eigen::ArrayXf intersection(b.Size());
+
+        // each row is the IoU of one box in a with all the boxes in b
+        for (Eigen::Index i = 0; i < a.Size(); i++)
+        {
+            width = (b.X2.min(a.X2(i)) - b.X1.max(a.X1(i))).max(0.0f);
+            height = (b.Y2.min(a.Y2(i)) - b.Y1.max(a.Y1(i))).max(0.0f);
+            intersection = width * height;
+
+            iou.row(i) = (intersection / (b.Area + a.Area(i) - intersection).max(std::numeric_limits<float>::min())).matrix().transpose();
+        }
+    }
+
+    // Mask IoU of all pairs
+    void MatchingEngine::ComputeIoUMatrix(const std::vector<BitMask>& a, const std::vector<BitMask>& b, IoUMatrix& iou)
+    {
+        iou.resize(static_cast<Eigen::Index>(a.size()), static_cast<Eigen::Index>(b.size()));
+
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            for (size_t j = 0; j < b.size(); j++) {
+                iou(i, j) = BitMask::IoU(a[i], b[j]);
+            }
+        }
+    }
+
+    // IoU of the detections with the given indices
+    void MatchingEngine::ComputeIoUMatrix(const std::vector<Detection::FumaroleDetection>& results, const std::vector<size_t>& resultIndices,
+                                          const std::vector<Detection::FumaroleDetection>& truth, const std::vector<size_t>& truthIndices,
+                                          IoUMode mode, IoUMatrix& iou)
+    {
+        if (mode == IOU_MASK) {
+            ComputeIoUMatrix(BitMask::Rasterize(results, resultIndices), BitMask::Rasterize(truth, truthIndices), iou);
+        }
+        else {
+            ComputeIoUMatrix(BoxArray(results, resultIndices), BoxArray(truth, truthIndices), iou);
+        }
+    }
+
+    // Greedy by score
+    std::vector<int> MatchingEngine::GreedyAssignment(const IoUMatrix& iou, const std::vector<float>& scores, float threshold)
+    {
+        std::vector<int> assignment(iou.rows(), -1);
+        std::vector<bool> used(iou.cols(), false);
+
+        std::vector<size_t> order(iou.rows());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t i, size_t j){ return scores[i] > scores[j]; });
+
+        for (size_t i : order)
+        {
+            int best = -1;
+            float bestIoU = threshold;
+
+            for (Eigen::Index j = 0; j < iou.cols(); j++)
+            {
+                if (!used[j] && iou(i, j) >= bestIoU && iou(i, j) > 0.0f) {
+                    best = static_cast<int>(j);
+                    bestIoU = iou(i, j);
+                }
+            }
+
+            if (best >= 0) {
+                assignment[i] = best;
+                used[best] = true;
+            }
+        }
+
+        return assignment;
+    }
+
+    // Hungarian method (shortest augmenting paths with potentials) on the cost 1 - IoU, padded to a square matrix
+    std::vector<int> MatchingEngine::HungarianAssignment(const IoUMatrix& iou, float threshold)
+    {
+        const int rows = static_cast<int>(iou.rows());
+        const int cols = static_cast<int>(iou.cols());
+        const int n = std::max(rows, cols);
+
+        std::vector<int> assignment(rows, -1);
+        if (rows == 0 || cols == 0) {
+            return assignment;
+        }
+
+        auto cost = [&](int i, int j) -> float {
+            return (i < rows && j < cols) ? 1.0f - iou(i, j) : 1.0f;
+        };
+
+        // 1-based potentials, the row matched to each column and the previous column on the augmenting path
+        const float inf = std::numeric_limits<float>::max();
+        std::vector<float> u(n + 1, 0.0f);
+        std::vector<float> v(n + 1, 0.0f);
+        std::vector<int> p(n + 1, 0);
+        std::vector<int> way(n + 1, 0);
+        std::vector<float> minValue(n + 1);
+        std::vector<bool> visited(n + 1);
+
+        for (int i = 1; i <= n; i++)
+        {
+            p[0] = i;
+            int j0 = 0;
+            std::fill(minValue.begin(), minValue.end(), inf);
+            std::fill(visited.begin(), visited.end(), false);
+
+            do
+            {
+                visited[j0] = true;
+                const int i0 = p[j0];
+                float delta = inf;
+                int j1 = 0;
+
+                for (int j = 1; j <= n; j++)
+                {
+                    if (visited[j]) {
+                        continue;
+                    }
+
+                    const float current = cost(i0 - 1, j - 1) - u[i0] - v[j];
+                    if (current < minValue[j]) {
+                        minValue[j] = current;
+                        way[j] = j0;
+                    }
+
+                    if (minValue[j] < delta) {
+                        delta = minValue[j];
+                        j1 = j;
+                    }
+                }
+
+                for (int j = 0; j <= n; j++)
+                {
+                    if (visited[j]) {
+                        u[p[j]] += delta;
+                        v[j] -= delta;
+                    }
+                    else {
+                        minValue[j] -= delta;
+                    }
+                }
+
+                j0 = j1;
+            }
+            while (p[j0] != 0);
+
+            // flip the augmenting path
+            do
+            {
+                const int j1 = way[j0];
+                p[j0] = p[j1];
+                j0 = j1;
+            }
+            while (j0 != 0);
+        }
+
+        // padded rows / columns and pairs below the threshold are not matches
+        for (int j = 1; j <= n; j++)
+        {
+            const int i = p[j] - 1;
+            if (i < rows && j - 1 < cols && iou(i, j - 1) > 0.0f && iou(i, j - 1) >= threshold) {
+                assignment[i] = j - 1;
+            }
+        }
+
+        return assignment;
+    }
+}
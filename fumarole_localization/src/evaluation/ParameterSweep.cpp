@@ -0,0 +1,179 @@
+//
+// ParameterSweep.cpp
+// Evaluates the detector over a grid of contour and classification params
+//
+
+#include "evaluation/ParameterSweep.hpp"
+#include "detection/FumaroleDetector.hpp"
+#include "pipeline/FumaroleLocalizer.hpp"
+#include "pipeline/ContourStore.hpp"
+
+#include <memory>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+#include <opencv2/core/utility.hpp>
+
+namespace Evaluation
+{
+    // Constructor
+    ParameterSweep::ParameterSweep(const std::map<std::string, std::string>& files, const std::map<std::string, std::vector<Detection::FumaroleDetection>>& truth, const Config::DetectorConfig& config) :
+        m_Files(files), m_Truth(truth), m_Config(config), m_Evaluator(config.Evaluation)
+    {
+
+    }
+
+    // Run the sweep
+    bool ParameterSweep::Run(const std::vector<float>& minAreas, const std::vector<float>& minAreasHeatedArea, const std::vector<float>& openVentRadii, const std::vector<float>& hiddenVentRadii, std::vector<SweepResult>& results)
+    {
+        // stage 1: threshold and contours (only run once)
+        if (!CacheContours()) {
+            return false;
+        }
+
+        // stage 2: min area filter and localization (only for min areas that were not run before)
+        CacheLocalizations(minAreas);
+
+        // stage 3: classification and evaluation for every grid point
+        std::vector<SweepParameters> grid;
+        for (float minArea : minAreas) {
+            for (float minAreaHeatedArea : minAreasHeatedArea) {
+                for (float openVentRadius : openVentRadii) {
+                    for (float hiddenVentRadius : hiddenVentRadii) {
+                        grid.push_back({ minArea, minAreaHeatedArea, openVentRadius, hiddenVentRadius });
+                    }
+                }
+            }
+        }
+
+        results.resize(grid.size());
+
+        std::cout << "\nEvaluating " << grid.size() << " grid points" << std::endl;
+        cv::parallel_for_(cv::Range(0, static_cast<int>(grid.size())), [&](const cv::Range& range) {
+            for (int i = range.start; i < range.end; i++) {
+                results[i] = EvaluateGridPoint(grid[i]);
+            }
+        });
+
+        return true;
+    }
+
+    // Run the pipeline up to the contours once for all images
+    bool ParameterSweep::CacheContours()
+    {
+        if (m_ContoursCached) {
+            return true;
+        }
+
+        // keep all contours so that any min area can be applied to the cached ones
+        Config::PipelineConfig unfiltered = m_Config.Pipeline;
+        unfiltered.ContourMinArea = 0.0;
+
+        Pipeline::Pipeline pipeline(m_Files, unfiltered, false, nullptr, Pipeline::PIPELINE_STAGE_CONTOURS);
+        const bool success = pipeline.Run();
+
+        if (!success) {
+            std::cerr << "\nFailed to run the pipeline for the contours" << std::endl;
+            return false;
+        }
+
+        m_Contours = pipeline.GetLocalizations();
+        m_ContoursCached = true;
+
+        return true;
+    }
+
+    // Filter the cached contours by each min area and localize them
+    void ParameterSweep::CacheLocalizations(const std::vector<float>& minAreas)
+    {
+        std::vector<float> missing;
+        for (float minArea : minAreas)
+        {
+            if (m_Localizations.find(minArea) == m_Localizations.end() && std::find(missing.begin(), missing.end(), minArea) == missing.end()) {
+                missing.push_back(minArea);
+            }
+        }
+
+        std::vector<Pipeline::PipelineLocalizations> localizations(missing.size());
+
+        cv::parallel_for_(cv::Range(0, static_cast<int>(missing.size())), [&](const cv::Range& range) {
+            Pipeline::FumaroleLocalizer localizer("localization", false);
+            cv::Mat output;
+            std::shared_ptr<void> result;
+
+            for (int i = range.start; i < range.end; i++)
+            {
+                for (const auto& contours : m_Contours)
+                {
+                    // same filter as the contour element of the pipeline
+                    auto filtered = std::make_shared<Pipeline::ContourStore>(contours.second);
+                    filtered->RemoveIf([&](const Pipeline::ContourFeatures& features) { return features.Area <= missing[i]; });
+
+                    localizer.Process(cv::Mat(), output, filtered, result, contours.first);
+                    localizations[i][contours.first] = std::move(*std::static_pointer_cast<Pipeline::ContourStore>(result));
+                }
+            }
+        });
+
+        for (size_t i = 0; i < missing.size(); i++) {
+            m_Localizations[missing[i]] = std::move(localizations[i]);
+        }
+    }
+
+    // Classify the cached localizations with the grid point params and evaluate them
+    SweepResult ParameterSweep::EvaluateGridPoint(const SweepParameters& parameters) const
+    {
+        Config::DetectorConfig config = m_Config;
+        config.Pipeline.ContourMinArea = parameters.MinArea;
+        config.Detection.MinAreaHeatedArea = parameters.MinAreaHeatedArea;
+        config.Detection.OpenVentSearchRadius = parameters.OpenVentRadius;
+        config.Detection.HiddenVentSearchRadius = parameters.HiddenVentRadius;
+
+        Detection::FumaroleDetector detector(config, false);
+        Memory::FrameArena arena;
+
+        std::map<std::string, std::vector<Detection::FumaroleDetection>> detections;
+        for (const auto& localization : m_Localizations.at(parameters.MinArea)) {
+            detections[localization.first] = detector.ClassifyLocalizations(localization.second, arena);
+        }
+
+        AlgorithmEvaluation eval = m_Evaluator.EvaluateDetectionPipeline(detections, m_Truth);
+
+        SweepResult result;
+        result.Parameters = parameters;
+        result.AverageIoU = eval.TotalAverageIoU;
+        result.ClassificationAccuracy = eval.ConfusionMatrix.GetAccuracy();
+        result.TotalNumberDetected = eval.TotalNumberDetected;
+        result.TotalNumberOfActualFumaroles = eval.TotalNumberOfActualFumaroles;
+
+        return result;
+    }
+
+    // Save results to CSV
+    void ParameterSweep::SaveResultsToCSV(const std::string& filePath, const std::vector<SweepResult>& results)
+    {
+        std::ofstream fs;
+        fs.open(filePath, std::ios::out);
+
+        // write header
+        fs << "min_area," << "min_area_heated_area," << "open_vent_radius_search," << "hidden_area_radius_search,";
+        fs << "avg_iou," << "classification_accuracy," << "detected," << "actual";
+
+        // write each grid point as a record
+        for (const SweepResult& r : results)
+        {
+            fs << "\n";
+            fs << r.Parameters.MinArea << ",";
+            fs << r.Parameters.MinAreaHeatedArea << ",";
+            fs << r.Parameters.OpenVentRadius << ",";
+            fs << r.Parameters.HiddenVentRadius << ",";
+            fs << r.AverageIoU << ",";
+            fs << r.ClassificationAccuracy << ",";
+            fs << r.TotalNumberDetected << ",";
+            fs << r.TotalNumberOfActualFumaroles;
+        }
+
+        fs.close();
+    }
+}
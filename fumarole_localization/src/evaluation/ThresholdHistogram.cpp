@@ -0,0 +1,199 @@
+//
+// ThresholdHistogram.cpp
+// Integer counts of values in fixed threshold bins
+//
+
+#include "evaluation/ThresholdHistogram.hpp"
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+
+namespace Evaluation
+{
+    // The most thresholds a histogram that is read may have (far more than any evaluation range uses)
+    const size_t MAX_THRESHOLDS { 1 << 16 };
+
+    // Constructor
+    ThresholdHistogram::ThresholdHistogram(float first, float step, int thresholds) : m_First(first), m_Step(step), m_Counts(std::max(thresholds, 0), 0)
+    {
+
+    }
+
+    // Bin of the first threshold >= value
+    void ThresholdHistogram::AddWithin(float value)
+    {
+        const int n = Thresholds();
+
+        // also catches NaN and infinity
+        if (n == 0 || !(value <= Threshold(n - 1))) {
+            m_Outside++;
+            return;
+        }
+
+        // the division only estimates the bin, the comparisons with the thresholds decide
+        int bin = static_cast<int>(std::ceil((value - m_First) / m_Step));
+        bin = std::min(std::max(bin, 0), n - 1);
+
+        while (bin > 0 && value <= Threshold(bin - 1)) {
+            bin--;
+        }
+        while (value > Threshold(bin)) {
+            bin++;
+        }
+
+        m_Counts[bin]++;
+    }
+
+    // Bin of the last threshold <= value
+    void ThresholdHistogram::AddReaching(float value)
+    {
+        const int n = Thresholds();
+
+        if (n == 0 || !(value >= Threshold(0))) {
+            m_Outside++;
+            return;
+        }
+
+        int bin = static_cast<int>(std::floor((value - m_First) / m_Step));
+        bin = std::min(std::max(bin, 0), n - 1);
+
+        while (bin + 1 < n && value >= Threshold(bin + 1)) {
+            bin++;
+        }
+        while (value < Threshold(bin)) {
+            bin--;
+        }
+
+        m_Counts[bin]++;
+    }
+
+    // Threshold of a bin
+    float ThresholdHistogram::Threshold(int bin) const {
+        return m_First + static_cast<float>(bin) * m_Step;
+    }
+
+    // Number of thresholds
+    int ThresholdHistogram::Thresholds() const {
+        return static_cast<int>(m_Counts.size());
+    }
+
+    // Number of values
+    int ThresholdHistogram::Total() const {
+        return std::accumulate(m_Counts.begin(), m_Counts.end(), m_Outside);
+    }
+
+    // Prefix sums
+    std::vector<int> ThresholdHistogram::CumulativeUp() const
+    {
+        std::vector<int> cumulative(m_Counts.size());
+        std::partial_sum(m_Counts.begin(), m_Counts.end(), cumulative.begin());
+
+        return cumulative;
+    }
+
+    // Suffix sums
+    std::vector<int> ThresholdHistogram::CumulativeDown() const
+    {
+        std::vector<int> cumulative(m_Counts.size());
+        std::partial_sum(m_Counts.rbegin(), m_Counts.rend(), cumulative.rbegin());
+
+        return cumulative;
+    }
+
+    // Add other histogram
+    ThresholdHistogram& ThresholdHistogram::operator+=(const ThresholdHistogram& other)
+    {
+        if (m_Counts.empty() && m_Outside == 0)
+        {
+            *this = other;
+            return *this;
+        }
+
+        if (other.m_Counts.size() != m_Counts.size() || other.m_First != m_First || other.m_Step != m_Step)
+        {
+            std::cerr << "\nCannot add histograms with different thresholds" << std::endl;
+            return *this;
+        }
+
+        for (size_t i = 0; i < m_Counts.size(); i++) {
+            m_Counts[i] += other.m_Counts[i];
+        }
+        m_Outside += other.m_Outside;
+
+        return *this;
+    }
+
+    // Write
+    void ThresholdHistogram::Write(std::ostream& os) const
+    {
+        const std::streamsize precision = os.precision(std::numeric_limits<float>::max_digits10);
+
+        os << m_First << " " << m_Step << " " << m_Outside << " " << m_Counts.size();
+        for (int count : m_Counts) {
+            os << " " << count;
+        }
+
+        os.precision(precision);
+    }
+
+    // Read
+    bool ThresholdHistogram::Read(std::istream& is)
+    {
+        float first = 0.0;
+        float step = 0.0;
+        int outside = 0;
+        size_t size = 0;
+
+        // checked before anything is allocated from the size, a corrupt histogram leaves this one unchanged
+        if (!(is >> first >> step >> outside >> size) || !std::isfinite(first) || !std::isfinite(step) || step <= 0.0f || outside < 0 || size > MAX_THRESHOLDS) {
+            is.setstate(std::ios::failbit);
+            return false;
+        }
+
+        std::vector<int> counts(size, 0);
+        for (int& count : counts)
+        {
+            if (!(is >> count) || count < 0) {
+                is.setstate(std::ios::failbit);
+                return false;
+            }
+        }
+
+        m_First = first;
+        m_Step = step;
+        m_Outside = outside;
+        m_Counts = std::move(counts);
+
+        return true;
+    }
+
+    // True and false positives per location error threshold
+    std::map<int, std::tuple<int, int>> DetectionCurve(const ThresholdHistogram& histogram)
+    {
+        std::map<int, std::tuple<int, int>> curve;
+        const std::vector<int> truePositives = histogram.CumulativeUp();
+        const int total = histogram.Total();
+
+        for (int i = 0; i < histogram.Thresholds(); i++) {
+            curve[static_cast<int>(std::lround(histogram.Threshold(i)))] = std::make_tuple(truePositives[i], total - truePositives[i]);
+        }
+
+        return curve;
+    }
+
+    // Success rate per IoU threshold
+    std::map<float, float> SuccessRateCurve(const ThresholdHistogram& histogram)
+    {
+        std::map<float, float> curve;
+        const std::vector<int> successes = histogram.CumulativeDown();
+        const int total = histogram.Total();
+
+        for (int i = 0; i < histogram.Thresholds(); i++) {
+            curve[histogram.Threshold(i)] = (total > 0 ? static_cast<float>(successes[i]) / static_cast<float>(total) : 0.0f);
+        }
+
+        return curve;
+    }
+}
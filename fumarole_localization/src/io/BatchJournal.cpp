@@ -0,0 +1,221 @@
+//
+// BatchJournal.cpp
+// Append-only journal of a batch run
+//
+
+#include "io/BatchJournal.hpp"
+#include "io/DetectionRecord.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace IO
+{
+    const std::string COMPLETED_RECORD { "done" };
+    const std::string FAILED_RECORD { "failed" };
+
+    // A record is a single line, so the control characters of a failure reason (e.g. the trailing newline of a
+    // cv::Exception) are replaced with spaces and the trailing ones are dropped
+    static std::string SanitizeReason(const std::string& reason)
+    {
+        std::string sanitized = reason;
+        for (char& c : sanitized) {
+            if (std::iscntrl(static_cast<unsigned char>(c))) {
+                c = ' ';
+            }
+        }
+
+        sanitized.erase(sanitized.find_last_not_of(' ') + 1);
+        return sanitized;
+    }
+
+    // Constructor
+    BatchJournal::BatchJournal(const std::string& path) : m_Path(path)
+    {
+
+    }
+
+    // Destructor
+    BatchJournal::~BatchJournal()
+    {
+        if (m_FileDescriptor >= 0) {
+            ::close(m_FileDescriptor);
+        }
+    }
+
+    // Read previous records and open for appending
+    bool BatchJournal::Open()
+    {
+        std::string content;
+        std::ifstream is(m_Path, std::ios::in | std::ios::binary);
+        if (is.is_open()) {
+            content.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+        }
+
+        // only lines ending in a line break were written completely
+        size_t validLength = 0;
+        size_t lineStart = 0;
+        size_t lineEnd = 0;
+
+        std::string recordType;
+        std::string fileID;
+        std::string reason;
+        std::string detectionRecord;
+        std::vector<Detection::FumaroleDetection> detections;
+
+        while ((lineEnd = content.find('\n', lineStart)) != std::string::npos)
+        {
+            // a record that cannot be parsed (e.g. torn by a crash) is skipped so its image is processed again
+            bool valid = false;
+            try
+            {
+                std::istringstream line(content.substr(lineStart, lineEnd - lineStart));
+                line >> recordType >> std::quoted(fileID);
+
+                if (line && recordType == COMPLETED_RECORD && std::getline(line >> std::ws, detectionRecord))
+                {
+                    // kept as text and only parsed when the image is resumed, but checked now so a corrupt record is reprocessed
+                    std::istringstream record(detectionRecord);
+                    if (ReadDetectionRecord(record, detections))
+                    {
+                        m_Completed[fileID] = detectionRecord;
+                        m_Failed.erase(fileID);
+                        valid = true;
+                    }
+                }
+                else if (line && recordType == FAILED_RECORD && line >> std::quoted(reason))
+                {
+                    m_Failed[fileID] = reason;
+                    valid = true;
+                }
+            }
+            catch (const std::exception&) {
+                valid = false;
+            }
+
+            if (!valid) {
+                std::cerr << "\nSkipping corrupt journal record in " << m_Path << std::endl;
+            }
+
+            lineStart = lineEnd + 1;
+            validLength = lineStart;
+        }
+
+        m_FileDescriptor = ::open(m_Path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (m_FileDescriptor < 0) {
+            std::cerr << "\nFailed to open journal " << m_Path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        // drop a partly written record at the end so the next record starts on a new line
+        if (validLength < content.size() && ::ftruncate(m_FileDescriptor, static_cast<off_t>(validLength)) != 0) {
+            std::cerr << "\nFailed to truncate journal " << m_Path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Get completed images
+    const std::map<std::string, std::string>& BatchJournal::GetCompleted() const {
+        return m_Completed;
+    }
+
+    // Read the detections of a completed image
+    bool BatchJournal::ReadCompleted(const std::string& fileID, std::vector<Detection::FumaroleDetection>& detections) const
+    {
+        auto iter = m_Completed.find(fileID);
+        if (iter == m_Completed.end()) {
+            detections.clear();
+            return false;
+        }
+
+        std::istringstream record(iter->second);
+        return ReadDetectionRecord(record, detections);
+    }
+
+    // Get failed images
+    const std::map<std::string, std::string>& BatchJournal::GetFailed() const {
+        return m_Failed;
+    }
+
+    // Check if image has a record
+    bool BatchJournal::IsRecorded(const std::string& fileID) const {
+        return (m_Completed.find(fileID) != m_Completed.end() || m_Failed.find(fileID) != m_Failed.end());
+    }
+
+    // Append completed image
+    bool BatchJournal::AppendCompleted(const std::string& fileID, const std::vector<Detection::FumaroleDetection>& detections)
+    {
+        std::ostringstream detectionRecord;
+        WriteDetectionRecord(detectionRecord, detections);
+
+        std::ostringstream record;
+        record << COMPLETED_RECORD << " " << std::quoted(fileID) << " " << detectionRecord.str() << "\n";
+
+        if (!Append(record.str())) {
+            return false;
+        }
+
+        m_Completed[fileID] = detectionRecord.str();
+        m_Failed.erase(fileID);
+        return true;
+    }
+
+    // Append failed image
+    bool BatchJournal::AppendFailed(const std::string& fileID, const std::string& reason)
+    {
+        const std::string sanitizedReason = SanitizeReason(reason);
+
+        std::ostringstream record;
+        record << FAILED_RECORD << " " << std::quoted(fileID) << " " << std::quoted(sanitizedReason) << "\n";
+
+        if (!Append(record.str())) {
+            return false;
+        }
+
+        m_Failed[fileID] = sanitizedReason;
+        return true;
+    }
+
+    // Write the record and sync it to disk
+    bool BatchJournal::Append(const std::string& record)
+    {
+        if (m_FileDescriptor < 0) {
+            std::cerr << "\nJournal " << m_Path << " is not open" << std::endl;
+            return false;
+        }
+
+        size_t written = 0;
+        while (written < record.size())
+        {
+            ssize_t n = ::write(m_FileDescriptor, record.data() + written, record.size() - written);
+            if (n < 0)
+            {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                std::cerr << "\nFailed to write journal " << m_Path << ": " << std::strerror(errno) << std::endl;
+                return false;
+            }
+
+            written += static_cast<size_t>(n);
+        }
+
+        if (::fsync(m_FileDescriptor) != 0) {
+            std::cerr << "\nFailed to sync journal " << m_Path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,79 @@
+//
+// DetectionRecord.cpp
+// Text records of detections for the files written by the detector (result cache, journal)
+//
+
+#include "io/DetectionRecord.hpp"
+
+#include <limits>
+#include <iomanip>
+
+namespace IO
+{
+    // Write record
+    void WriteDetectionRecord(std::ostream& os, const std::vector<Detection::FumaroleDetection>& detections)
+    {
+        const std::streamsize precision = os.precision(std::numeric_limits<double>::max_digits10);
+
+        os << detections.size();
+
+        for (const Detection::FumaroleDetection& d : detections)
+        {
+            const Pipeline::ContourFeatures& f = d.Features;
+
+            os << " " << static_cast<int>(d.Type) << " " << d.Score << " " << d.BoundingBox.x << " " << d.BoundingBox.y << " " << d.BoundingBox.width << " " << d.BoundingBox.height;
+            os << " " << f.Area << " " << f.Perimeter << " " << f.BoundingBox.x << " " << f.BoundingBox.y << " " << f.BoundingBox.width << " " << f.BoundingBox.height;
+            os << " " << f.Centroid.x << " " << f.Centroid.y << " " << f.Band << " " << f.PeakIntensity << " " << d.Contour.size();
+
+            for (const cv::Point& p : d.Contour) {
+                os << " " << p.x << " " << p.y;
+            }
+        }
+
+        os.precision(precision);
+    }
+
+    // Read record
+    bool ReadDetectionRecord(std::istream& is, std::vector<Detection::FumaroleDetection>& detections)
+    {
+        size_t count = 0;
+        is >> count;
+
+        // nothing is reserved from the counts of the record, a corrupt count must not allocate more than the record holds
+        detections.clear();
+
+        int type = 0;
+        int length = 0;
+        cv::Point point;
+
+        for (size_t i = 0; i < count && is; i++)
+        {
+            Detection::FumaroleDetection d;
+            Pipeline::ContourFeatures& f = d.Features;
+
+            is >> type >> d.Score >> d.BoundingBox.x >> d.BoundingBox.y >> d.BoundingBox.width >> d.BoundingBox.height;
+            is >> f.Area >> f.Perimeter >> f.BoundingBox.x >> f.BoundingBox.y >> f.BoundingBox.width >> f.BoundingBox.height;
+            is >> f.Centroid.x >> f.Centroid.y >> f.Band >> f.PeakIntensity >> length;
+
+            if (!is || type < 0 || type > Model::UNKNOWN || length < 0) {
+                break;
+            }
+
+            d.Type = static_cast<Model::FumaroleType>(type);
+            for (int p = 0; p < length && is; p++)
+            {
+                is >> point.x >> point.y;
+                d.Contour.push_back(point);
+            }
+
+            detections.emplace_back(std::move(d));
+        }
+
+        if (!is || detections.size() != count) {
+            detections.clear();
+            return false;
+        }
+
+        return true;
+    }
+}
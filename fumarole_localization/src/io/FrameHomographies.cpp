@@ -0,0 +1,70 @@
+//
+// FrameHomographies.cpp
+// Per-frame homographies from image pixels to world coordinates
+//
+
+#include "io/FrameHomographies.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+
+namespace IO
+{
+    const size_t HOMOGRAPHY_FIELDS { 10 };
+
+    // Load the homographies
+    bool LoadFrameHomographies(const std::string& filePath, FrameHomographies& homographies)
+    {
+        homographies.clear();
+
+        std::ifstream is(filePath, std::ios::in);
+        if (!is.is_open()) {
+            std::cerr << "\nFailed to open homographies " << filePath << std::endl;
+            return false;
+        }
+
+        std::string line;
+        std::vector<std::string> fields;
+        int lineNumber = 0;
+
+        while (std::getline(is, line))
+        {
+            lineNumber++;
+            boost::trim(line);
+
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+
+            boost::split(fields, line, boost::is_any_of(","));
+
+            try
+            {
+                if (fields.size() != HOMOGRAPHY_FIELDS) {
+                    throw std::invalid_argument("expected " + std::to_string(HOMOGRAPHY_FIELDS) + " fields");
+                }
+
+                cv::Matx33d homography;
+                for (size_t i = 1; i < HOMOGRAPHY_FIELDS; i++) {
+                    homography.val[i - 1] = std::stod(fields[i]);
+                }
+
+                homographies[boost::trim_copy(fields[0])] = homography;
+            }
+            catch (const std::exception& e)
+            {
+                // the header line has no numbers
+                if (lineNumber == 1) {
+                    continue;
+                }
+
+                std::cerr << "\nMalformed homography on line " << lineNumber << " of " << filePath << ": " << e.what() << std::endl;
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
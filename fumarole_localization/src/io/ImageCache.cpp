@@ -0,0 +1,89 @@
+//
+// ImageCache.cpp
+// In-memory cache of decoded thermal images shared by concurrent detection runs
+//
+
+#include "io/ImageCache.hpp"
+
+#include <opencv2/highgui/highgui.hpp>
+
+namespace IO
+{
+    // Constructor
+    ImageCache::ImageCache(size_t maxBytes) : m_MaxBytes(maxBytes)
+    {
+
+    }
+
+    // Load
+    bool ImageCache::Load(const std::string& path, cv::Mat& image)
+    {
+        std::promise<cv::Mat> decoded;
+        std::shared_future<cv::Mat> pending;
+        bool decodeHere = false;
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            auto iter = m_Images.find(path);
+            if (iter != m_Images.end()) {
+                pending = iter->second;
+            }
+            else {
+                m_Images.emplace(path, decoded.get_future().share());
+                decodeHere = true;
+            }
+        }
+
+        // decoded (or being decoded) by another load
+        if (!decodeHere)
+        {
+            m_Hits++;
+            image = pending.get();
+
+            return (image.data != nullptr);
+        }
+
+        m_Misses++;
+
+        // decode outside of the lock so other images are decoded concurrently
+        try {
+            image = cv::imread(path, cv::IMREAD_GRAYSCALE);
+        }
+        catch (...)
+        {
+            // the waiting loads fail the same way and the next load tries again
+            decoded.set_exception(std::current_exception());
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Images.erase(path);
+            throw;
+        }
+
+        decoded.set_value(image);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        // a file that could not be read is not kept (the next load tries again) and over the limit the image is only given
+        // to the loads that were waiting for it
+        const size_t bytes = image.total() * image.elemSize();
+        if (!image.data || (m_MaxBytes > 0 && m_Bytes + bytes > m_MaxBytes)) {
+            m_Images.erase(path);
+        }
+        else {
+            m_Bytes += bytes;
+        }
+
+        return (image.data != nullptr);
+    }
+
+    // Hits
+    size_t ImageCache::GetHits() const {
+        return m_Hits;
+    }
+
+    // Misses
+    size_t ImageCache::GetMisses() const {
+        return m_Misses;
+    }
+}
@@ -0,0 +1,100 @@
+//
+// ResultCache.cpp
+// Persistent cache of the detections for each image
+//
+
+#include "io/ResultCache.hpp"
+#include "io/DetectionRecord.hpp"
+#include "config/config.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <boost/filesystem.hpp>
+
+namespace IO
+{
+    // Constructor
+    ResultCache::ResultCache(const std::string& directory, uint64_t configHash) : m_Directory(directory), m_ConfigHash(configHash)
+    {
+        // create cache dir if needed
+        if (!boost::filesystem::exists(m_Directory)) {
+            boost::filesystem::create_directories(m_Directory);
+        }
+    }
+
+    // Lookup
+    bool ResultCache::Lookup(const std::string& imagePath, uint64_t& key, std::vector<Detection::FumaroleDetection>& detections) const
+    {
+        // hash the content of the image file (not the decoded image so the file is only read once)
+        std::ifstream is(imagePath, std::ios::in | std::ios::binary);
+        if (!is.is_open()) {
+            return false;
+        }
+
+        std::vector<char> content((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+
+        key = Hash(content.data(), content.size());
+        key = Hash(&m_ConfigHash, sizeof(m_ConfigHash), key);
+        key = Hash(Config::DETECTOR_VERSION.data(), Config::DETECTOR_VERSION.size(), key);
+
+        std::ifstream entry(EntryPath(key), std::ios::in);
+        if (!entry.is_open()) {
+            return false;
+        }
+
+        // a truncated or corrupt entry is a miss (it is overwritten by the new result)
+        return ReadDetectionRecord(entry, detections);
+    }
+
+    // Store
+    bool ResultCache::Store(uint64_t key, const std::vector<Detection::FumaroleDetection>& detections) const
+    {
+        // written to a temp file first and renamed so a partly written entry is never read
+        const std::string path = EntryPath(key);
+        const std::string tempPath = path + ".tmp";
+
+        std::ofstream fs(tempPath, std::ios::out | std::ios::trunc);
+        if (!fs.is_open()) {
+            std::cerr << "\nFailed to write result cache entry: " << tempPath << std::endl;
+            return false;
+        }
+
+        WriteDetectionRecord(fs, detections);
+
+        fs.close();
+        if (!fs) {
+            std::cerr << "\nFailed to write result cache entry: " << tempPath << std::endl;
+            return false;
+        }
+
+        boost::system::error_code error;
+        boost::filesystem::rename(tempPath, path, error);
+
+        return !error;
+    }
+
+    // FNV-1a
+    uint64_t ResultCache::Hash(const void* data, size_t size, uint64_t hash)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+
+        return hash;
+    }
+
+    // Path of the entry file
+    std::string ResultCache::EntryPath(uint64_t key) const
+    {
+        std::ostringstream ss;
+        ss << m_Directory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".txt";
+
+        return ss.str();
+    }
+}
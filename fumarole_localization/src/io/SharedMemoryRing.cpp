@@ -0,0 +1,214 @@
+//
+// SharedMemoryRing.cpp
+// Single producer / single consumer ring of fixed size slots in POSIX shared memory
+//
+
+#include "io/SharedMemoryRing.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace IO
+{
+    const uint32_t RING_MAGIC { 0x46524E47 };
+    const uint32_t RING_VERSION { 1 };
+    const size_t CACHE_LINE { 64 };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring counters must be lock-free to be shared between processes");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "the ring magic must be lock-free to be shared between processes");
+
+    // Start of the shared memory (head and tail on separate cache lines so producer and consumer do not contend)
+    struct SharedMemoryRing::Header
+    {
+        std::atomic<uint32_t> Magic;
+        uint32_t Version;
+        uint32_t SlotCount;
+        uint32_t SlotSize;
+
+        // number of slots published by the producer
+        alignas(CACHE_LINE) std::atomic<uint64_t> Head;
+
+        // number of slots released by the consumer
+        alignas(CACHE_LINE) std::atomic<uint64_t> Tail;
+    };
+
+    // Round up to a multiple of the cache line
+    static size_t AlignToCacheLine(size_t size)
+    {
+        return (size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    }
+
+    // Destructor
+    SharedMemoryRing::~SharedMemoryRing()
+    {
+        if (m_Header != nullptr) {
+            ::munmap(m_Header, m_MappedSize);
+        }
+
+        if (m_Owner) {
+            ::shm_unlink(m_Name.c_str());
+        }
+    }
+
+    // Create
+    bool SharedMemoryRing::Create(const std::string& name, uint32_t slotCount, uint32_t slotSize)
+    {
+        if (slotCount == 0 || slotSize == 0) {
+            std::cerr << "\nInvalid ring " << name << ": " << slotCount << " slots of " << slotSize << " bytes" << std::endl;
+            return false;
+        }
+
+        // a ring left by a crashed run is replaced
+        ::shm_unlink(name.c_str());
+
+        const int descriptor = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+        if (descriptor < 0) {
+            std::cerr << "\nFailed to create shared memory " << name << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        m_Name = name;
+        m_Owner = true;
+        m_SlotStride = AlignToCacheLine(slotSize);
+
+        const size_t size = AlignToCacheLine(sizeof(Header)) + m_SlotStride * slotCount;
+        if (::ftruncate(descriptor, static_cast<off_t>(size)) < 0)
+        {
+            std::cerr << "\nFailed to size shared memory " << name << ": " << std::strerror(errno) << std::endl;
+            ::close(descriptor);
+            return false;
+        }
+
+        if (!Map(descriptor, size)) {
+            return false;
+        }
+
+        // the atomics of the header only exist once constructed in the mapped memory (zeroed, so the magic is not set yet)
+        m_Header = new (m_Header) Header {};
+        m_Header->Version = RING_VERSION;
+        m_Header->SlotCount = slotCount;
+        m_Header->SlotSize = slotSize;
+        m_Header->Head.store(0, std::memory_order_relaxed);
+        m_Header->Tail.store(0, std::memory_order_relaxed);
+
+        // the ring can be opened once the magic is visible
+        m_Header->Magic.store(RING_MAGIC, std::memory_order_release);
+
+        return true;
+    }
+
+    // Open
+    bool SharedMemoryRing::Open(const std::string& name)
+    {
+        const int descriptor = ::shm_open(name.c_str(), O_RDWR, 0);
+        if (descriptor < 0) {
+            std::cerr << "\nFailed to open shared memory " << name << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        struct stat status {};
+        if (::fstat(descriptor, &status) < 0 || static_cast<size_t>(status.st_size) < sizeof(Header))
+        {
+            std::cerr << "\nShared memory " << name << " is not a ring" << std::endl;
+            ::close(descriptor);
+            return false;
+        }
+
+        m_Name = name;
+        if (!Map(descriptor, static_cast<size_t>(status.st_size))) {
+            return false;
+        }
+
+        if (m_Header->Magic.load(std::memory_order_acquire) != RING_MAGIC || m_Header->Version != RING_VERSION || m_Header->SlotCount == 0)
+        {
+            std::cerr << "\nShared memory " << name << " is not a ring of version " << RING_VERSION << std::endl;
+            return false;
+        }
+
+        m_SlotStride = AlignToCacheLine(m_Header->SlotSize);
+        if (AlignToCacheLine(sizeof(Header)) + m_SlotStride * m_Header->SlotCount > m_MappedSize)
+        {
+            std::cerr << "\nShared memory " << name << " is smaller than its slots" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Begin write
+    void* SharedMemoryRing::BeginWrite()
+    {
+        const uint64_t head = m_Header->Head.load(std::memory_order_relaxed);
+        const uint64_t tail = m_Header->Tail.load(std::memory_order_acquire);
+
+        return (head - tail < m_Header->SlotCount ? Slot(head) : nullptr);
+    }
+
+    // End write
+    void SharedMemoryRing::EndWrite()
+    {
+        // the slot contents are visible to the consumer before the new head
+        m_Header->Head.store(m_Header->Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Begin read
+    const void* SharedMemoryRing::BeginRead()
+    {
+        const uint64_t tail = m_Header->Tail.load(std::memory_order_relaxed);
+        const uint64_t head = m_Header->Head.load(std::memory_order_acquire);
+
+        return (tail != head ? Slot(tail) : nullptr);
+    }
+
+    // End read
+    void SharedMemoryRing::EndRead()
+    {
+        // the slot is only overwritten by the producer after it sees the new tail
+        m_Header->Tail.store(m_Header->Tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Slot size
+    uint32_t SharedMemoryRing::GetSlotSize() const {
+        return m_Header->SlotSize;
+    }
+
+    // Slot count
+    uint32_t SharedMemoryRing::GetSlotCount() const {
+        return m_Header->SlotCount;
+    }
+
+    // Queued slots
+    uint64_t SharedMemoryRing::GetQueued() const {
+        return m_Header->Head.load(std::memory_order_acquire) - m_Header->Tail.load(std::memory_order_acquire);
+    }
+
+    // Map the shared memory (the descriptor is closed)
+    bool SharedMemoryRing::Map(int descriptor, size_t size)
+    {
+        void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        ::close(descriptor);
+
+        if (memory == MAP_FAILED) {
+            std::cerr << "\nFailed to map shared memory " << m_Name << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        m_Header = static_cast<Header*>(memory);
+        m_Slots = static_cast<uint8_t*>(memory) + AlignToCacheLine(sizeof(Header));
+        m_MappedSize = size;
+
+        return true;
+    }
+
+    // Slot of a counter value
+    void* SharedMemoryRing::Slot(uint64_t index) const {
+        return m_Slots + (index % m_Header->SlotCount) * m_SlotStride;
+    }
+}
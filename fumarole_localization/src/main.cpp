@@ -8,11 +8,25 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <memory>
+#include <algorithm>
+#include <csignal>
+#include <stdexcept>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <boost/filesystem.hpp>
 
 #include "model/FumaroleType.hpp"
 #include "detection/FumaroleDetector.hpp"
+#include "io/BatchJournal.hpp"
+#include "io/FrameHomographies.hpp"
+#include "detection/WorldDeduplicator.hpp"
+#include "detection/FumaroleTracker.hpp"
+#include "server/DetectionServer.hpp"
+#include "server/SharedMemoryIngest.hpp"
+#include "config/ConfigParser.hpp"
 
 const int REQ_PARAMS_COUNT = 2;
 
@@ -23,23 +37,75 @@ const std::vector<std::string> SUPPORTED_FILE_TYPES = {
         ".exr"
 };
 
-void WriteDetectionsToCSVFile(const std::map<std::string, std::vector<Detection::FumaroleDetection>>& detections, const std::string& outputDir);
+bool WriteDetectionsToCSVFile(const std::string& fileID, const std::vector<Detection::FumaroleDetection>& detections, const std::string& outputDir, bool sync);
+bool SyncToDisk(const std::string& path);
+bool TrackSequence(const std::map<std::string, std::vector<Detection::FumaroleDetection>>& sequence, const std::string& outputDir);
+int Serve(const std::string& socketPath);
+int IngestSharedMemory(const std::string& frameRingName, const std::string& resultRingName);
+
+// the running server or ingest (stopped on SIGINT / SIGTERM)
+Server::DetectionServer* g_Server = nullptr;
+Server::SharedMemoryIngest* g_Ingest = nullptr;
 
 int main(int argc, char** argv)
 {
+    // optional journal for resuming an interrupted run (--journal [file path])
+    std::vector<std::string> params;
+    std::string journalPath;
+    std::string socketPath;
+    std::string frameRingName;
+    std::string resultRingName;
+    std::string homographiesPath;
+    bool track = false;
+
+    for (int i = 0; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--journal" && i + 1 < argc) {
+            journalPath = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--serve" && i + 1 < argc) {
+            socketPath = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--shm" && i + 2 < argc) {
+            frameRingName = argv[++i];
+            resultRingName = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--homographies" && i + 1 < argc) {
+            homographiesPath = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--track") {
+            track = true;
+        }
+        else {
+            params.emplace_back(argv[i]);
+        }
+    }
+
+    // server mode - answer detection requests on a Unix domain socket until stopped (--serve [socket path])
+    if (!socketPath.empty()) {
+        return Serve(socketPath);
+    }
+
+    // shared memory mode - detect the frames a capture process writes into a ring (--shm [frame ring] [result ring])
+    if (!frameRingName.empty()) {
+        return IngestSharedMemory(frameRingName, resultRingName);
+    }
+
     // required params check
-    if (argc < REQ_PARAMS_COUNT) {
-        std::cout << "\nUsage: fumarole_localization [file path for directory of thermal images] [optional: output folder path]\n" << std::endl;
+    if (params.size() < REQ_PARAMS_COUNT) {
+        std::cout << "\nUsage: fumarole_localization [file path for directory of thermal images] [optional: output folder path] [optional: --journal journal file path] [optional: --homographies homographies csv path] [optional: --track]\n" << std::endl;
+        std::cout << "       fumarole_localization --serve [socket path]\n" << std::endl;
+        std::cout << "       fumarole_localization --shm [frame ring name] [result ring name]\n" << std::endl;
         return 1;
     }
 
     // get params and optional params
-    std::string thermalImagesDir { argv[1] };
+    std::string thermalImagesDir { params[1] };
 
     // param 3 is optional output dir
     std::string csvOutputDir { "detector_csv_output" };
-    if (argc == 3) {
-        csvOutputDir = argv[2];
+    if (params.size() == 3) {
+        csvOutputDir = params[2];
     }
 
     // load images from directory
@@ -60,47 +126,199 @@ int main(int argc, char** argv)
         }
     }
 
-    // create detector with no intermediate output and run detector
-    std::map<std::string, std::vector<Detection::FumaroleDetection>> detections;
+    // optional homographies of the frames for merging the detections of overlapping frames (--homographies [csv path])
+    IO::FrameHomographies homographies;
+    if (!homographiesPath.empty() && !IO::LoadFrameHomographies(homographiesPath, homographies)) {
+        return 1;
+    }
+
+    Detection::WorldDeduplicator deduplicator(Config::ConfigParser::GetInstance().GetDetectorConfig().Deduplication.MergeRadius);
+    size_t framesWithoutHomography = 0;
+
+    // detections of each frame of a video sequence for tracking (--track), in the order of the file ids once all frames are done
+    std::map<std::string, std::vector<Detection::FumaroleDetection>> sequence;
 
+    // both are fed from the sink, which also receives the frames completed in a previous run of the journal (replayed from
+    // their journaled detections), so the tracks and the world features of a resumed run cover all frames
+
+    // create detector with no intermediate output
     Detection::FumaroleDetector detector(false);
-    detector.DetectFumaroles(files, detections);
 
-    // write to csv files
-    std::cout << "\n\nImages processed. Writing detections to CSV files to " << csvOutputDir << std::endl;
-    WriteDetectionsToCSVFile(detections, csvOutputDir);
+    // completed images are appended to the journal as they finish and skipped when the run is restarted
+    std::unique_ptr<IO::BatchJournal> journal;
+    if (!journalPath.empty())
+    {
+        journal = std::make_unique<IO::BatchJournal>(journalPath);
+        if (!journal->Open()) {
+            return 1;
+        }
 
-    return 0;
-}
+        std::cout << "\nResuming from journal " << journalPath << ": " << journal->GetCompleted().size() << " completed, " << journal->GetFailed().size() << " failed" << std::endl;
+        detector.SetJournal(journal.get());
+    }
 
-// write the detections to the csv file
-void WriteDetectionsToCSVFile(const std::map<std::string, std::vector<Detection::FumaroleDetection>>& detections, const std::string& outputDir)
-{
     // create output dir if needed
-    if (!boost::filesystem::exists(outputDir)) {
-        boost::filesystem::create_directories(outputDir);
+    if (!boost::filesystem::exists(csvOutputDir)) {
+        boost::filesystem::create_directories(csvOutputDir);
     }
 
+    // run detector and write the csv file of each image as soon as its detections are ready
+    std::cout << "\nWriting detections to CSV files to " << csvOutputDir << std::endl;
+    const bool completed = detector.DetectFumaroles(files, [&](const std::string& fileID, const std::vector<Detection::FumaroleDetection>& detections) {
+        // with a journal the file must be on disk before the image is journaled as completed (after the sink returns),
+        // throwing records the image as failed instead
+        if (!WriteDetectionsToCSVFile(fileID, detections, csvOutputDir, journal != nullptr)) {
+            throw std::runtime_error("failed to write the detections of " + fileID);
+        }
+
+        if (track)
+        {
+            // the tracker only needs the boxes, the contours would keep every frame in memory
+            std::vector<Detection::FumaroleDetection>& frameDetections = sequence[fileID];
+            frameDetections = detections;
+            for (auto& d : frameDetections) {
+                std::vector<cv::Point>().swap(d.Contour);
+            }
+        }
+
+        if (homographiesPath.empty()) {
+            return;
+        }
+
+        auto homography = homographies.find(fileID);
+        if (homography == homographies.end()) {
+            framesWithoutHomography++;
+            return;
+        }
+
+        deduplicator.AddFrame(fileID, homography->second, detections);
+    });
+
+    std::cout << "\n\nImages processed." << std::endl;
+
+    std::cout << detector.GetRunSummary();
+
+    // e.g. the journal could not be written, the images that are not journaled are processed again when resuming
+    if (!completed) {
+        std::cerr << "\nThe batch was stopped before all images were processed" << std::endl;
+        return 1;
+    }
+
+    // stable IDs for the fumaroles over the frames of the sequence
+    if (track && !TrackSequence(sequence, csvOutputDir)) {
+        return 1;
+    }
+
+    // one record per physical fumarole over all frames
+    if (!homographiesPath.empty())
+    {
+        const std::string worldPath = csvOutputDir + "/world_features.csv";
+        if (!deduplicator.SaveToCSV(worldPath)) {
+            return 1;
+        }
+
+        std::cout << "\nMerged " << deduplicator.GetObservationCount() << " detections into " << deduplicator.GetFeatures().size() << " world features in " << worldPath << std::endl;
+        if (framesWithoutHomography > 0) {
+            std::cout << framesWithoutHomography << " frames had no homography and were not merged" << std::endl;
+        }
+    }
+
+    return 0;
+}
+
+// write the detections of an image to its csv file
+bool WriteDetectionsToCSVFile(const std::string& fileID, const std::vector<Detection::FumaroleDetection>& detections, const std::string& outputDir, bool sync)
+{
+    // create full path for the csv file for this image
     std::string path;
+    path += outputDir;
+    path += "/";
+    path += fileID;
+    path += ".csv";
+
+    // write detections for this csv file
+    std::ofstream fs(path, std::ios::out);
+
+    // write header
+    fs << "x_min,x_max,y_min,y_max,width,height,class_label";
 
-    for (const auto& pair : detections)
+    // write each detection as a record
+    for (const auto& d : detections)
     {
-        // create full path for the csv file for this image
-        path += outputDir;
-        path += "/";
-        path += pair.first;
-        path += ".csv";
+        fs << "\n";
+        fs << d.BoundingBox.x << ",";
+        fs << d.BoundingBox.x + d.BoundingBox.width << ",";
+        fs << d.BoundingBox.y << ",";
+        fs << d.BoundingBox.y + d.BoundingBox.height << ",";
+        fs << d.BoundingBox.width << ",";
+        fs << d.BoundingBox.height << ",";
+        fs << Model::TypeNameString(d.Type);
+    }
+
+    fs.close();
+    if (fs.fail()) {
+        std::cerr << "\nFailed to write " << path << std::endl;
+        return false;
+    }
 
-        // write detections for this csv file
-        std::ofstream fs(path, std::ios::out);
+    // the file and its directory entry (a new file) are synced
+    return !sync || (SyncToDisk(path) && SyncToDisk(outputDir));
+}
 
-        // write header
-        fs << "x_min,x_max,y_min,y_max,width,height,class_label";
+// sync a file or directory to disk
+bool SyncToDisk(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "\nFailed to open " << path << " for syncing" << std::endl;
+        return false;
+    }
+
+    const bool synced = (::fsync(fd) == 0);
+    ::close(fd);
+
+    if (!synced) {
+        std::cerr << "\nFailed to sync " << path << std::endl;
+    }
+
+    return synced;
+}
+
+// track the detections over the frames of a sequence (ordered by file id) and write the track of each detection
+bool TrackSequence(const std::map<std::string, std::vector<Detection::FumaroleDetection>>& sequence, const std::string& outputDir)
+{
+    const std::string path = outputDir + "/tracks.csv";
+    std::ofstream fs(path, std::ios::out);
+    if (!fs.is_open()) {
+        std::cerr << "\nFailed to write " << path << std::endl;
+        return false;
+    }
+
+    Detection::FumaroleTracker tracker(Config::ConfigParser::GetInstance().GetDetectorConfig().Tracking);
+    std::vector<uint64_t> trackIDs;
+    double totalMilliseconds = 0.0;
+    double maxMilliseconds = 0.0;
+
+    // write header
+    fs << "file_id,track_id,x_min,x_max,y_min,y_max,width,height,class_label";
+
+    for (const auto& frame : sequence)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        tracker.Update(frame.second, trackIDs);
+        const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 
-        // write each detection as a record
-        for (const auto& d : pair.second)
+        totalMilliseconds += milliseconds;
+        maxMilliseconds = std::max(maxMilliseconds, milliseconds);
+
+        // write each detection with its track as a record
+        for (size_t i = 0; i < frame.second.size(); i++)
         {
+            const Detection::FumaroleDetection& d = frame.second[i];
+
             fs << "\n";
+            fs << frame.first << ",";
+            fs << trackIDs[i] << ",";
             fs << d.BoundingBox.x << ",";
             fs << d.BoundingBox.x + d.BoundingBox.width << ",";
             fs << d.BoundingBox.y << ",";
@@ -109,9 +327,62 @@ void WriteDetectionsToCSVFile(const std::map<std::string, std::vector<Detection:
             fs << d.BoundingBox.height << ",";
             fs << Model::TypeNameString(d.Type);
         }
+    }
+
+    std::cout << "\nWrote tracks to " << path << std::endl;
+    std::cout << tracker.GetStats();
+    std::cout << "Tracking Mean (ms) = " << (sequence.empty() ? 0.0 : totalMilliseconds / sequence.size()) << "\nTracking Max (ms) = " << maxMilliseconds << std::endl;
+
+    return true;
+}
 
-        // clear path
-        path.clear();
+// run the detection server on the socket
+int Serve(const std::string& socketPath)
+{
+    // the workers, batches and client limits are in the server section of the config snapshot
+    const Config::DetectorConfig& config = Config::ConfigParser::GetInstance().GetDetectorConfig();
+
+    Server::DetectionServer server(config, socketPath);
+    if (!server.Start()) {
+        return 1;
     }
+
+    g_Server = &server;
+    std::signal(SIGINT, [](int) { g_Server->Stop(); });
+    std::signal(SIGTERM, [](int) { g_Server->Stop(); });
+
+    std::cout << "\nServing detections on " << socketPath << " with " << config.Server.Workers << " workers" << std::endl;
+    server.Run();
+
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    g_Server = nullptr;
+    std::cout << server.GetStats();
+
+    return 0;
 }
 
+// detect the frames of a shared memory ring
+int IngestSharedMemory(const std::string& frameRingName, const std::string& resultRingName)
+{
+    Server::SharedMemoryIngest ingest(Config::ConfigParser::GetInstance().GetDetectorConfig(), frameRingName, resultRingName);
+    if (!ingest.Start()) {
+        return 1;
+    }
+
+    g_Ingest = &ingest;
+    std::signal(SIGINT, [](int) { g_Ingest->Stop(); });
+    std::signal(SIGTERM, [](int) { g_Ingest->Stop(); });
+
+    std::cout << "\nDetecting frames of " << frameRingName << " into " << resultRingName << std::endl;
+    ingest.Run();
+
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    g_Ingest = nullptr;
+
+    std::cout << ingest.GetStats();
+    std::cout << ingest.GetLatencySummary();
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+//
+// FrameArena.cpp
+// Monotonic memory arena for all allocations made while processing a single frame
+//
+
+#include "memory/FrameArena.hpp"
+
+#include <algorithm>
+
+namespace Memory
+{
+    // Accumulate stats
+    AllocationStats& AllocationStats::operator+=(const AllocationStats& other)
+    {
+        Releases += other.Releases;
+        ArenaAllocations += other.ArenaAllocations;
+        ArenaBytes += other.ArenaBytes;
+        HeapAllocations += other.HeapAllocations;
+        HeapBytes += other.HeapBytes;
+        BufferSize = std::max(BufferSize, other.BufferSize);
+
+        return *this;
+    }
+
+    // Output allocation report
+    std::ostream& operator<<(std::ostream& os, const AllocationStats& stats)
+    {
+        os << "\nArena releases = " << stats.Releases;
+        os << "\nArena allocations = " << stats.ArenaAllocations << " (" << stats.ArenaBytes << " bytes)";
+        os << "\nHeap allocations (arena overflow) = " << stats.HeapAllocations << " (" << stats.HeapBytes << " bytes)";
+        os << "\nArena buffer size = " << stats.BufferSize << " bytes";
+        os << "\n(only allocations through the arena are counted, OpenCV buffers and the output detections use the heap)";
+
+        return os;
+    }
+
+    // Counting resource
+    CountingResource::CountingResource(std::pmr::memory_resource* upstream) : m_Upstream(upstream)
+    {
+
+    }
+
+    void* CountingResource::do_allocate(size_t bytes, size_t alignment)
+    {
+        m_Allocations++;
+        m_Bytes += bytes;
+        return m_Upstream->allocate(bytes, alignment);
+    }
+
+    void CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+    {
+        m_Upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+
+    // Constructor
+    FrameArena::FrameArena(size_t initialSize) : m_Buffer(initialSize), m_Heap(std::pmr::new_delete_resource()), m_Resource(nullptr)
+    {
+        m_Arena.emplace(m_Buffer.data(), m_Buffer.size(), &m_Heap);
+        m_Resource.SetUpstream(&*m_Arena);
+        m_Stats.BufferSize = m_Buffer.size();
+    }
+
+    // Resource for frame allocations
+    std::pmr::memory_resource* FrameArena::Resource()
+    {
+        return &m_Resource;
+    }
+
+    // Release the frame
+    void FrameArena::Release()
+    {
+        const size_t frameBytes = m_Resource.Bytes() - m_Stats.ArenaBytes;
+        const bool overflowed = m_Heap.Allocations() > m_Stats.HeapAllocations;
+
+        m_Stats.Releases++;
+        m_Stats.ArenaAllocations = m_Resource.Allocations();
+        m_Stats.ArenaBytes = m_Resource.Bytes();
+        m_Stats.HeapAllocations = m_Heap.Allocations();
+        m_Stats.HeapBytes = m_Heap.Bytes();
+
+        if (overflowed)
+        {
+            // grow the buffer so that a frame like this one fits without going to the heap next time
+            m_Arena.reset();
+            m_Buffer = std::vector<std::byte>(std::max(m_Buffer.size() * 2, frameBytes * 2));
+            m_Arena.emplace(m_Buffer.data(), m_Buffer.size(), &m_Heap);
+            m_Resource.SetUpstream(&*m_Arena);
+            m_Stats.BufferSize = m_Buffer.size();
+        }
+        else {
+            m_Arena->release();
+        }
+    }
+
+    // Get stats
+    const AllocationStats& FrameArena::Stats() const
+    {
+        return m_Stats;
+    }
+}
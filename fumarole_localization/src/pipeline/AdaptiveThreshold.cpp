@@ -0,0 +1,120 @@
+//
+// AdaptiveThreshold.cpp
+// Performs a locally adaptive threshold for hot areas
+//
+
+#include "pipeline/AdaptiveThreshold.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+namespace Pipeline
+{
+    const int MAX_ADAPTIVE_RANGES { 4 };
+    const int TILE_ROWS { 32 };
+
+    // Constructor
+    AdaptiveThreshold::AdaptiveThreshold(const std::string &name, bool saveResults, const Config::PipelineConfig& config) : PipelineElement(name, saveResults), m_HeatRanges(config.HeatRanges)
+    {
+        // check to ensure max 4 ranges
+        if (m_HeatRanges.size() > MAX_ADAPTIVE_RANGES) {
+            std::cerr << "\nOnly a max of 4 ranges is supported. Ignoring excess ranges" << std::endl;
+            m_HeatRanges.resize(MAX_ADAPTIVE_RANGES);
+        }
+
+        // neighbourhood params
+        m_WindowRadius = std::max(config.AdaptiveWindowSize / 2, 1);
+        m_K = config.AdaptiveK;
+    }
+
+    // Process
+    void AdaptiveThreshold::Process(const cv::Mat& input, cv::Mat& output, const std::shared_ptr<void>& previousElementResult, std::shared_ptr<void>& result, const std::string& filename)
+    {
+        // local mean and std dev for any window size are O(1) per pixel from the integral images
+        ComputeIntegralImages(input);
+
+        output.create(input.rows, input.cols, CV_8UC4);
+
+        // threshold independent row tiles in parallel
+        cv::parallel_for_(cv::Range(0, input.rows), [&](const cv::Range& range) {
+            ThresholdRows(input, output, range.start, range.end);
+        }, std::max(input.rows / TILE_ROWS, 1));
+
+        // save intermediate results if required
+        if (m_SaveIntermediateResults)
+        {
+            std::vector<cv::Mat> thresholds;
+            cv::split(output, thresholds);
+
+            for (int i = 0; i < m_HeatRanges.size(); i++) {
+                SaveResult(thresholds[i], std::to_string(i) + "_" + filename);
+            }
+        }
+    }
+
+    // Compute the sum and squared sum integral images of the input padded by the window radius
+    void AdaptiveThreshold::ComputeIntegralImages(const cv::Mat& input)
+    {
+        // padding with replicated borders keeps every window full size so the inner loop has no edge cases
+        cv::copyMakeBorder(input, m_Padded, m_WindowRadius, m_WindowRadius, m_WindowRadius, m_WindowRadius, cv::BORDER_REPLICATE);
+        cv::integral(m_Padded, m_Sum, m_SquaredSum, CV_64F, CV_64F);
+    }
+
+    // Apply the adaptive threshold to the rows [rowStart, rowEnd) and store each heat range in a separate channel
+    void AdaptiveThreshold::ThresholdRows(const cv::Mat& input, cv::Mat& output, int rowStart, int rowEnd) const
+    {
+        const int d = 2 * m_WindowRadius + 1;
+        const double invArea = 1.0 / static_cast<double>(d * d);
+        const int cols = input.cols;
+
+        // lower bounds of the heat ranges - unused channels can never pass
+        int lower[MAX_ADAPTIVE_RANGES] { 256, 256, 256, 256 };
+        for (int i = 0; i < m_HeatRanges.size(); i++) {
+            lower[i] = m_HeatRanges[i];
+        }
+
+        std::vector<float> localThreshold(cols);
+        std::vector<float> localMean(cols);
+
+        for (int row = rowStart; row < rowEnd; row++)
+        {
+            const double* sumTop = m_Sum.ptr<double>(row);
+            const double* sumBottom = m_Sum.ptr<double>(row + d);
+            const double* sqSumTop = m_SquaredSum.ptr<double>(row);
+            const double* sqSumBottom = m_SquaredSum.ptr<double>(row + d);
+
+            // local threshold = mean + k * std dev of the window
+            for (int col = 0; col < cols; col++)
+            {
+                double sum = sumBottom[col + d] - sumTop[col + d] - sumBottom[col] + sumTop[col];
+                double sqSum = sqSumBottom[col + d] - sqSumTop[col + d] - sqSumBottom[col] + sqSumTop[col];
+                double mean = sum * invArea;
+                double variance = std::max(sqSum * invArea - mean * mean, 0.0);
+
+                localThreshold[col] = static_cast<float>(mean + m_K * std::sqrt(variance));
+                localMean[col] = static_cast<float>(mean);
+            }
+
+            // keep the intensity in each channel where the pixel passes both thresholds (same as THRESH_TOZERO)
+            const uchar* in = input.ptr<uchar>(row);
+            uchar* out = output.ptr<uchar>(row);
+
+            for (int col = 0; col < cols; col++)
+            {
+                const int value = in[col];
+                const bool isLocallyHot = value > localThreshold[col];
+
+                // a window whose mean is in the range lies inside a hot area, where the local contrast says nothing
+                for (int c = 0; c < MAX_ADAPTIVE_RANGES; c++) {
+                    const bool isHot = isLocallyHot || localMean[col] > lower[c];
+                    out[col * MAX_ADAPTIVE_RANGES + c] = (isHot && value > lower[c]) ? static_cast<uchar>(value) : 0;
+                }
+            }
+        }
+    }
+}
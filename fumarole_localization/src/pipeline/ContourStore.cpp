@@ -0,0 +1,92 @@
+//
+// ContourStore.cpp
+// Flat storage for a set of contours
+//
+
+#include "pipeline/ContourStore.hpp"
+
+namespace Pipeline
+{
+    // Constructor
+    ContourStore::ContourStore(std::pmr::memory_resource* resource) : m_Points(resource), m_Offsets(resource), m_Lengths(resource), m_Bands(resource), m_Features(resource)
+    {
+
+    }
+
+    // Append contour
+    void ContourStore::Add(const cv::Point* points, int count, const ContourFeatures& features)
+    {
+        m_Offsets.push_back(static_cast<int>(m_Points.size()));
+        m_Lengths.push_back(count);
+        m_Bands.push_back(features.Band);
+        m_Features.push_back(features);
+
+        m_Points.insert(m_Points.end(), points, points + count);
+    }
+
+    // Append contour
+    void ContourStore::Add(const std::vector<cv::Point>& points, const ContourFeatures& features)
+    {
+        Add(points.data(), static_cast<int>(points.size()), features);
+    }
+
+    // Append contour from other store
+    void ContourStore::Append(const ContourStore& other, size_t index)
+    {
+        Add(other.Points(index), other.Length(index), other.Features(index));
+    }
+
+    // Append all contours of the other store with an offset
+    void ContourStore::Append(const ContourStore& other, const cv::Point& offset)
+    {
+        const size_t firstPoint = m_Points.size();
+        const size_t firstContour = Size();
+
+        for (size_t i = 0; i < other.Size(); i++) {
+            Append(other, i);
+        }
+
+        for (size_t i = firstPoint; i < m_Points.size(); i++) {
+            m_Points[i] += offset;
+        }
+
+        for (size_t i = firstContour; i < Size(); i++)
+        {
+            m_Features[i].BoundingBox.x += offset.x;
+            m_Features[i].BoundingBox.y += offset.y;
+            m_Features[i].Centroid += cv::Point2f(offset);
+        }
+    }
+
+    // Matrix header over the points
+    cv::Mat ContourStore::PointsMat(size_t index) const
+    {
+        return cv::Mat(m_Lengths[index], 1, CV_32SC2, const_cast<cv::Point*>(Points(index)));
+    }
+
+    // Copy points
+    std::vector<cv::Point> ContourStore::CopyPoints(size_t index) const
+    {
+        return std::vector<cv::Point>(Points(index), Points(index) + Length(index));
+    }
+
+    // Remove all
+    void ContourStore::Clear()
+    {
+        m_Points.clear();
+        m_Offsets.clear();
+        m_Lengths.clear();
+        m_Bands.clear();
+        m_Features.clear();
+    }
+
+    // Reserve memory
+    void ContourStore::Reserve(size_t contours, size_t points)
+    {
+        m_Points.reserve(points);
+        m_Offsets.reserve(contours);
+        m_Lengths.reserve(contours);
+        m_Bands.reserve(contours);
+        m_Features.reserve(contours);
+    }
+}
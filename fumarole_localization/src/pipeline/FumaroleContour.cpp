@@ -6,7 +6,6 @@
 
 #include "pipeline/Typedefs.hpp"
 #include "pipeline/FumaroleContour.hpp"
-#include "config/ConfigParser.hpp"
 #include "io/fumarole_data_io.hpp"
 
 #include <memory>
@@ -18,10 +17,9 @@
 namespace Pipeline
 {
     // Constructor
-    FumaroleContour::FumaroleContour(const std::string &name, bool saveResults) : PipelineElement(name, saveResults)
+    FumaroleContour::FumaroleContour(const std::string &name, bool saveResults, const Config::PipelineConfig& config) : PipelineElement(name, saveResults), m_MinAreaFilter(config.ContourMinArea)
     {
-        // read in min area param
-        m_MinAreaFilter = Config::ConfigParser::GetInstance().GetValue<float>("config.pipeline.contour.min_area");
+
     }
 
     // Destructor
@@ -30,13 +28,21 @@ namespace Pipeline
     // Processing
     void FumaroleContour::Process(const cv::Mat &input, cv::Mat &output, const std::shared_ptr<void>& previousElementResult, std::shared_ptr<void>& result, const std::string &filename)
     {
-        auto contours = std::make_shared<FumaroleContours>();
+        auto contours = std::allocate_shared<FumaroleContours>(std::pmr::polymorphic_allocator<FumaroleContours>(m_MemoryResource), m_MemoryResource);
 
         // split into channels - each channel is a separate heat thresholded image
-        std::vector<cv::Mat> images;
+        std::vector<cv::Mat>& images = m_Channels;
         cv::split(input, images);
         for (int i = 0; i < images.size(); i++) {
-            contours->emplace_back(FindContours(images[i]));
+            FindContours(images[i], i, *contours);
+        }
+
+        // filter out noise (contours with very small areas) by compacting the store
+        contours->RemoveIf([&](const ContourFeatures& features) { return features.Area <= m_MinAreaFilter; });
+
+        // the remaining features are only computed for the contours that were kept
+        for (size_t i = 0; i < contours->Size(); i++) {
+            ComputeFeatures(images[contours->Band(i)], *contours, i);
         }
 
         // set the result of the processing (contours)
@@ -44,59 +50,86 @@ namespace Pipeline
 
         // Save contour results if set
         if (m_SaveIntermediateResults) {
-            SaveContourResults(*contours, filename);
+            SaveContourResults(*contours, static_cast<int>(images.size()), filename);
         }
     }
 
-    // Finds contours in the given image
-    std::vector<std::vector<cv::Point>> FumaroleContour::FindContours(const cv::Mat& image) const
+    // Finds contours in the given image and appends them to the store with their area
+    void FumaroleContour::FindContours(const cv::Mat& image, int band, FumaroleContours& contours)
     {
-        std::vector<cv::Vec4i> hierarchy;
-        std::vector<std::vector<cv::Point>> contours;
+        cv::findContours(image, m_FoundContours, m_Hierarchy, cv::RetrievalModes::RETR_EXTERNAL, cv::ContourApproximationModes::CHAIN_APPROX_SIMPLE);
 
-        cv::findContours(image, contours, hierarchy, cv::RetrievalModes::RETR_EXTERNAL, cv::ContourApproximationModes::CHAIN_APPROX_SIMPLE);
+        ContourFeatures features;
+        features.Band = band;
 
-        // filter out noise (contours with very small areas)
-        if (!contours.empty()) {
-            FilterContourNoise(contours);
+        for (const std::vector<cv::Point>& points : m_FoundContours)
+        {
+            features.Area = cv::contourArea(points);
+            contours.Add(points, features);
         }
-
-        return std::move(contours);
     }
 
-    // Remove the contours that are detected as noise (small area)
-    void FumaroleContour::FilterContourNoise(std::vector<std::vector<cv::Point>>& contours) const
+    // Compute the remaining features of the contour at the given index
+    void FumaroleContour::ComputeFeatures(const cv::Mat& image, FumaroleContours& contours, size_t index) const
     {
-        auto iter = contours.begin();
-        while (iter != contours.end())
-        {
-            if (cv::contourArea(*iter) <= m_MinAreaFilter) {
-                iter = contours.erase(iter);
-            }
-            else {
-                iter++;
-            }
+        ContourFeatures& features = contours.Features(index);
+        const cv::Mat points = contours.PointsMat(index);
+
+        features.Perimeter = cv::arcLength(points, true);
+        features.BoundingBox = cv::boundingRect(points);
+
+        cv::Moments m = cv::moments(points);
+        if (m.m00 > 0.0) {
+            features.Centroid = cv::Point2f(static_cast<float>(m.m10 / m.m00), static_cast<float>(m.m01 / m.m00));
+        }
+        else {
+            features.Centroid = cv::Point2f(features.BoundingBox.x + features.BoundingBox.width / 2.0f, features.BoundingBox.y + features.BoundingBox.height / 2.0f);
         }
+
+        // peak intensity inside the contour (the thresholded channel keeps the thermal intensities)
+        const cv::Point* polygon = contours.Points(index);
+        const int length = contours.Length(index);
+
+        cv::Mat mask = cv::Mat::zeros(features.BoundingBox.height, features.BoundingBox.width, CV_8U);
+        cv::fillPoly(mask, &polygon, &length, 1, cv::Scalar(255), cv::LINE_8, 0, -features.BoundingBox.tl());
+
+        double peak = 0.0;
+        cv::minMaxLoc(image(features.BoundingBox), nullptr, &peak, nullptr, nullptr, mask);
+        features.PeakIntensity = static_cast<int>(peak);
     }
 
     // Save intermediate contour results
-    void FumaroleContour::SaveContourResults(const FumaroleContours& contours, const std::string& filename) const
+    void FumaroleContour::SaveContourResults(const FumaroleContours& contours, int bands, const std::string& filename) const
     {
-        int i = 0;
-        for (const std::vector<std::vector<cv::Point>>& contoursForThermalRange : contours)
+        std::vector<const cv::Point*> polygons;
+        std::vector<int> lengths;
+
+        for (int band = 0; band < bands; band++)
         {
             cv::Mat output;
 
             if (!IO::GetFullResCamImage(filename, output)) {
                 std::cerr << "\nContour: Failed to get image: " << filename << std::endl;
+                continue;
             }
             //IO::GetThermalImage(filename, output, true);
 
-            if (!contoursForThermalRange.empty()) {
-                cv::drawContours(output, contoursForThermalRange, -1, cv::Scalar(0, 0, 255));
+            // draw the contours of this thermal range straight from the store
+            polygons.clear();
+            lengths.clear();
+            for (size_t i = 0; i < contours.Size(); i++)
+            {
+                if (contours.Band(i) == band) {
+                    polygons.push_back(contours.Points(i));
+                    lengths.push_back(contours.Length(i));
+                }
+            }
+
+            if (!polygons.empty()) {
+                cv::polylines(output, polygons.data(), lengths.data(), static_cast<int>(polygons.size()), true, cv::Scalar(0, 0, 255));
             }
 
-            SaveResult(output, std::to_string(i++) + "_" + filename);
+            SaveResult(output, std::to_string(band) + "_" + filename);
         }
     }
 }
@@ -29,15 +29,25 @@ namespace Pipeline
     {
         // the merged contours that will be the final, localized fumaroles
         // after examining the contours from the different thermal ranges in the channels
-        std::vector<std::vector<cv::Point>> contoursForImage;
+        auto contoursForImage = std::allocate_shared<FumaroleContours>(std::pmr::polymorphic_allocator<FumaroleContours>(m_MemoryResource), m_MemoryResource);
 
         // get contours from previous pipeline element result
         auto contours = std::static_pointer_cast<FumaroleContours>(previousElementResult);
 
-        // loop through the contours backwards (hot contours to cold)
-        for (auto iter = contours->rbegin(); iter != contours->rend(); iter++) {
-            std::copy_if(iter->begin(), iter->end(), std::back_inserter(contoursForImage), [&](const std::vector<cv::Point>& c) { return !IsContourEnclosingSomeContour(
-                    c, contoursForImage); });
+        int maxBand = -1;
+        for (size_t i = 0; i < contours->Size(); i++) {
+            maxBand = std::max(maxBand, contours->Band(i));
+        }
+
+        // loop through the bands backwards (hot contours to cold)
+        for (int band = maxBand; band >= 0; band--)
+        {
+            for (size_t i = 0; i < contours->Size(); i++)
+            {
+                if (contours->Band(i) == band && !IsContourEnclosingSomeContour(contours->Features(i), *contoursForImage)) {
+                    contoursForImage->Append(*contours, i);
+                }
+            }
         }
 
         // draw the final contours onto the image
@@ -45,35 +55,41 @@ namespace Pipeline
         {
             //IO::GetThermalImage(filename, output, true);
             IO::GetFullResCamImage(filename, output);
-            if (!contoursForImage.empty()) {
-                cv::drawContours(output, contoursForImage, -1, cv::Scalar(0, 0, 255), 2);
+            if (!contoursForImage->Empty())
+            {
+                std::vector<const cv::Point*> polygons;
+                std::vector<int> lengths;
+                for (size_t i = 0; i < contoursForImage->Size(); i++) {
+                    polygons.push_back(contoursForImage->Points(i));
+                    lengths.push_back(contoursForImage->Length(i));
+                }
+                cv::polylines(output, polygons.data(), lengths.data(), static_cast<int>(polygons.size()), true, cv::Scalar(0, 0, 255), 2);
             }
             SaveResult(output, filename);
         }
 
-        // set result to vector of contours
-        std::shared_ptr<std::vector<std::vector<cv::Point>>> contourList = std::make_shared<std::vector<std::vector<cv::Point>>>(contoursForImage);
-        result = contourList;
+        // set result to the store of localized contours
+        result = contoursForImage;
     }
 
     // Return true if inner contour is inside outer contour
-    bool FumaroleLocalizer::IsContourEnclosingContour(const std::vector<cv::Point> &outer,
-                                                      const std::vector<cv::Point> &inner) const
+    bool FumaroleLocalizer::IsContourEnclosingContour(const ContourFeatures &outer,
+                                                      const ContourFeatures &inner) const
     {
-        // convert both to bounding boxes and check if inside
-        cv::Rect innerRect = cv::boundingRect(inner);
-        cv::Rect outerRect = cv::boundingRect(outer);
+        // check if the bounding boxes (computed when the contours were found) are inside
+        const cv::Rect& innerRect = inner.BoundingBox;
+        const cv::Rect& outerRect = outer.BoundingBox;
 
         return ((innerRect & outerRect) == innerRect);
     }
 
     // Returns true if the given contour is enclosing any one of the contours in contours
-    bool FumaroleLocalizer::IsContourEnclosingSomeContour(const std::vector<cv::Point> &contour,
-                                                          std::vector<std::vector<cv::Point>> &contours) const
+    bool FumaroleLocalizer::IsContourEnclosingSomeContour(const ContourFeatures &contour,
+                                                          const FumaroleContours &contours) const
     {
-        for (const std::vector<cv::Point>& c : contours)
+        for (size_t i = 0; i < contours.Size(); i++)
         {
-            if (IsContourEnclosingContour(contour, c)) {
+            if (IsContourEnclosingContour(contour, contours.Features(i))) {
                 return true;
             }
         }
@@ -4,13 +4,11 @@
 //
 
 #include "pipeline/HeatThreshold.hpp"
-#include "config/ConfigParser.hpp"
 
 #include <iostream>
 #include <string>
 #include <vector>
 #include <algorithm>
-#include <boost/algorithm/string.hpp>
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
@@ -19,50 +17,31 @@ namespace Pipeline
     const int MAX_RANGES { 4 };
 
     // Constructor
-    HeatThreshold::HeatThreshold(const std::string &name, bool saveResults) : PipelineElement(name, saveResults)
+    HeatThreshold::HeatThreshold(const std::string &name, bool saveResults, const Config::PipelineConfig& config) : PipelineElement(name, saveResults), m_HeatRanges(config.HeatRanges)
     {
-        // read in the heat ranges
-        std::string bins = Config::ConfigParser::GetInstance().GetValue<std::string>("config.pipeline.histogram.bins");
-        std::vector<std::string> binValues;
-        boost::split(binValues, bins, boost::is_space());
-
         // check to ensure max 4 ranges
-        if (binValues.size() > MAX_RANGES) {
+        if (m_HeatRanges.size() > MAX_RANGES) {
             std::cerr << "\nOnly a max of 4 ranges is supported. Ignoring excess ranges" << std::endl;
-            binValues.erase(binValues.begin() + MAX_RANGES, binValues.end());
+            m_HeatRanges.resize(MAX_RANGES);
         }
-
-        std::transform(binValues.begin(), binValues.end(), std::back_inserter(m_HeatRanges), [&](const std::string& str) { return std::stoi(str); });
     }
 
     // Process
     void HeatThreshold::Process(const cv::Mat& input, cv::Mat& output, const std::shared_ptr<void>& previousElementResult, std::shared_ptr<void>& result, const std::string& filename)
     {
-        int lower = 0;
-        int upper = 0;
-        int c = 0;
-
-        // set output image
-        output = cv::Mat(input.rows, input.cols, CV_8UC4);
-
-        // apply threshold and save in separate channel of output
-        for (auto iter = m_HeatRanges.begin(); iter != m_HeatRanges.end(); iter++)
-        {
-            lower = *iter;
-            auto nextIter = std::next(iter, 1);
-            upper = (nextIter != m_HeatRanges.end() ? *nextIter : 256);
+        // the output buffer is kept between frames and only reallocated when the frame size changes
+        m_Thresholds.create(input.rows, input.cols, CV_8UC4);
+        output = m_Thresholds;
 
-            ThresholdImage(input, output, c, lower, upper);
-
-            c++;
-        }
+        // apply all thresholds in one pass, each range in a separate channel of output
+        ThresholdImage(input, output);
 
         // save intermediate results if required
         if (m_SaveIntermediateResults)
         {
             std::vector<cv::Mat> thresholds;
             cv::split(output, thresholds);
-            c = 0;
+            int c = 0;
 
             for (int i = 0; i < m_HeatRanges.size(); i++) {
                 SaveResult(thresholds[i], std::to_string(c++) + "_" + filename);
@@ -70,20 +49,27 @@ namespace Pipeline
         }
     }
 
-    // Apply threshold to input and store in given channel
-    void HeatThreshold::ThresholdImage(const cv::Mat &input, cv::Mat &output, int channel, int lower, int upper)
+    // Apply the threshold of each range to input and store each in its channel of output
+    void HeatThreshold::ThresholdImage(const cv::Mat &input, cv::Mat &output) const
     {
-        cv::Mat thresholdOutput;
-        cv::threshold(input, thresholdOutput, lower, 255, cv::THRESH_TOZERO);
-        cv::Vec4b channels;
+        // channels without a range stay empty (no intensity is above 255)
+        int lower[MAX_RANGES];
+        for (int c = 0; c < MAX_RANGES; c++) {
+            lower[c] = (c < m_HeatRanges.size() ? m_HeatRanges[c] : 255);
+        }
 
-        for (int row = 0; row < output.rows; row++)
+        for (int row = 0; row < input.rows; row++)
         {
-            for (int col = 0; col < output.cols; col++)
+            const uchar* pixels = input.ptr<uchar>(row);
+            uchar* channels = output.ptr<uchar>(row);
+
+            for (int col = 0; col < input.cols; col++)
             {
-                channels = output.at<cv::Vec4b>(row, col);
-                channels[channel] = thresholdOutput.at<uchar>(row, col);
-                output.at<cv::Vec4b>(row, col) = channels;
+                // same as cv::THRESH_TOZERO - intensities above the lower bound are kept, others set to 0
+                const uchar value = pixels[col];
+                for (int c = 0; c < MAX_RANGES; c++) {
+                    channels[MAX_RANGES * col + c] = (value > lower[c] ? value : 0);
+                }
             }
         }
     }
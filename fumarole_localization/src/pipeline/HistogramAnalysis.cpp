@@ -7,28 +7,20 @@
 //
 
 #include "pipeline/HistogramAnalysis.hpp"
-#include "config/ConfigParser.hpp"
 
 #include <opencv2/imgproc/imgproc.hpp>
 #include <iostream>
 #include <string>
 #include <algorithm>
-#include <boost/algorithm/string.hpp>
 
 namespace Pipeline
 {
     const float MIN_REL_FREQUENCY_REQ = 0.1;
 
-    HistogramAnalysis::HistogramAnalysis(const std::string &name, bool saveResults) : PipelineElement(name, saveResults)
+    HistogramAnalysis::HistogramAnalysis(const std::string &name, bool saveResults, const Config::PipelineConfig& config) : PipelineElement(name, saveResults)
     {
-        // init the frequencies for the bins to 0 (read from config file)
-        std::string bins = Config::ConfigParser::GetInstance().GetValue<std::string>("config.pipeline.histogram.bins");
-        std::vector<std::string> binValues;
-
-        boost::split(binValues, bins, boost::is_space());
-
-        for (int i = 0; i < binValues.size(); i++) {
-            int binNumber = std::stoi(binValues[i]);
+        // init the frequencies for the bins to 0
+        for (int binNumber : config.HeatRanges) {
             m_BinFrequencies[binNumber] = 0;
         }
     }
@@ -6,77 +6,286 @@
 
 #include <memory>
 #include <utility>
+#include <exception>
 #include <iostream>
+#include <algorithm>
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
 #include "pipeline/Pipeline.hpp"
 #include "pipeline/HeatThreshold.hpp"
+#include "pipeline/AdaptiveThreshold.hpp"
 #include "pipeline/HistogramAnalysis.hpp"
 #include "pipeline/FumaroleContour.hpp"
 #include "pipeline/FumaroleLocalizer.hpp"
+#include "pipeline/RegionProposal.hpp"
+#include "pipeline/Typedefs.hpp"
 
 namespace Pipeline
 {
+    const int COLD_CHECK_STRIDE { 8 };
+
     // Constructor that runs on multiple images
-    Pipeline::Pipeline(const std::map<std::string, std::string>& files, bool saveResults) : m_Files(files), m_SaveResults(saveResults)
+    Pipeline::Pipeline(const std::map<std::string, std::string>& files, const Config::PipelineConfig& config, bool saveResults, Memory::FrameArena* arena, PipelineStage lastStage) : m_Files(files), m_Arena(arena), m_SaveResults(saveResults), m_LastStage(lastStage)
     {
-        // 1. Heat threshold - remove cold temperature range from thermal
-        std::unique_ptr<HeatThreshold> heat = std::make_unique<HeatThreshold>("heat_threshold", m_SaveResults);
-        m_Elements.emplace_back(std::move(heat));
+        // per-frame results are allocated from the frame arena (owned by the pipeline if none is given)
+        if (m_Arena == nullptr) {
+            m_OwnedArena = std::make_unique<Memory::FrameArena>();
+            m_Arena = m_OwnedArena.get();
+        }
+
+        // 1. Heat threshold - remove cold temperature range from thermal (globally or relative to the local neighbourhood)
+        if (config.ThresholdMethod == "adaptive") {
+            std::unique_ptr<AdaptiveThreshold> adaptive = std::make_unique<AdaptiveThreshold>("adaptive_threshold", m_SaveResults, config);
+            m_Elements.emplace_back(std::move(adaptive));
+        }
+        else {
+            std::unique_ptr<HeatThreshold> heat = std::make_unique<HeatThreshold>("heat_threshold", m_SaveResults, config);
+            m_Elements.emplace_back(std::move(heat));
+        }
 
         // 2. Contour detection - detect all contours present in the segmented image
-        std::unique_ptr<FumaroleContour> contour = std::make_unique<FumaroleContour>("contours", m_SaveResults);
+        std::unique_ptr<FumaroleContour> contour = std::make_unique<FumaroleContour>("contours", m_SaveResults, config);
         m_Elements.emplace_back(std::move(contour));
 
         // 3. Localize all contours to outline fumaroles
-        std::unique_ptr<FumaroleLocalizer> localizer = std::make_unique<FumaroleLocalizer>("localization", m_SaveResults);
-        m_Elements.emplace_back(std::move(localizer));
+        if (m_LastStage == PIPELINE_STAGE_LOCALIZATIONS) {
+            std::unique_ptr<FumaroleLocalizer> localizer = std::make_unique<FumaroleLocalizer>("localization", m_SaveResults);
+            m_Elements.emplace_back(std::move(localizer));
+        }
+
+        // Frames with no pixel above the lowest heat range have nothing to detect and are skipped
+        m_LowestHeatRange = config.LowestHeatRange();
+
+        // Coarse-to-fine mode - propose regions on a downsampled level that are then run through the elements above
+        if (config.PyramidEnabled) {
+            m_RegionProposal = std::make_unique<RegionProposal>("region_proposal", m_SaveResults, config);
+            m_RegionProposal->SetMemoryResource(m_Arena->Resource());
+        }
+
+        for (const auto& element : m_Elements) {
+            element->SetMemoryResource(m_Arena->Resource());
+        }
     }
 
     // Destructor
     Pipeline::~Pipeline() {}
 
     // Processing the pipeline
-    cv::Mat input;
-    cv::Mat output;
-
-    std::shared_ptr<void> result;
-    std::shared_ptr<void> previousResult;
-
     bool Pipeline::Run()
     {
+        cv::Mat input;
+        ContourStore contours;
+
         for (const auto& file : m_Files)
         {
+            if (m_Stopped) {
+                return false;
+            }
+
             std::cout << "\nProcessing " << file.first;
 
-            // read in image
-            input = std::move(cv::imread(file.second, cv::IMREAD_GRAYSCALE));
-            if (!input.data) {
-                std::cerr << "\nFailed to read file: " << file.second << std::endl;
-                return false;
+            // a failing image is recorded and does not stop the other images from being processed
+            try {
+                RunOnFile(file.first, file.second, input, contours);
             }
+            catch (const std::exception& e) {
+                contours.Clear();
+                m_Arena->Release();
+                RecordFailure(file.first, e.what());
+            }
+        }
 
-            for (const auto & m_Element : m_Elements)
+        return !m_Stopped;
+    }
+
+    // Stop the run
+    void Pipeline::Stop() {
+        m_Stopped = true;
+    }
+
+    // Process a single image
+    void Pipeline::RunOnFile(const std::string& fileID, const std::string& path, cv::Mat& input, ContourStore& contours)
+    {
+        // read in image
+        bool loaded = true;
+        if (m_ImageLoader) {
+            loaded = m_ImageLoader(path, input);
+        }
+        else {
+            input = cv::imread(path, cv::IMREAD_GRAYSCALE);
+        }
+
+        if (!loaded || !input.data) {
+            RecordFailure(fileID, "Failed to read file: " + path);
+            return;
+        }
+
+        ProcessFrame(input, fileID, contours);
+
+        if (m_LocalizationCallback) {
+            m_LocalizationCallback(fileID, contours);
+        }
+        else {
+            m_Localizations[fileID] = std::move(contours);
+        }
+    }
+
+    // Record an image that failed
+    void Pipeline::RecordFailure(const std::string& fileID, const std::string& reason)
+    {
+        std::cerr << "\nFailed to process " << fileID << ": " << reason << std::endl;
+        m_Failures[fileID] = reason;
+
+        if (m_FailureCallback) {
+            m_FailureCallback(fileID, reason);
+        }
+    }
+
+    // Process a decoded frame
+    void Pipeline::ProcessFrame(const cv::Mat& image, const std::string& fileID, ContourStore& contours)
+    {
+        // cold frames short-circuit with no localizations
+        if (IsColdFrame(image))
+        {
+            contours.Clear();
+            m_SkippedFrames++;
+        }
+        else if (m_RegionProposal) {
+            // run on the candidate regions of the frame
+            RunOnRegions(image, fileID, contours);
+        }
+        else {
+            // run on the whole frame
+            RunOnFrame(image, fileID, contours);
+        }
+
+        // the localizations are copied out of the arena before everything allocated for the frame is released
+        m_Arena->Release();
+    }
+
+    // Returns true if no pixel in the frame is above the lowest heat range (all thresholds would be empty)
+    bool Pipeline::IsColdFrame(const cv::Mat& image) const
+    {
+        // a strided sample finds most hot frames without touching the whole frame
+        for (int row = 0; row < image.rows; row += COLD_CHECK_STRIDE)
+        {
+            const uchar* p = image.ptr<uchar>(row);
+            for (int col = 0; col < image.cols; col += COLD_CHECK_STRIDE)
+            {
+                if (p[col] > m_LowestHeatRange) {
+                    return false;
+                }
+            }
+        }
+
+        // otherwise the (vectorized) max of the full frame decides
+        double maxValue = 0.0;
+        cv::minMaxLoc(image, nullptr, &maxValue);
+
+        return (maxValue <= m_LowestHeatRange);
+    }
+
+    // Pass the full resolution frame through each element in the pipeline
+    void Pipeline::RunOnFrame(const cv::Mat& image, const std::string& fileID, ContourStore& contours)
+    {
+        cv::Mat input = image;
+        cv::Mat output;
+
+        std::shared_ptr<void> result;
+        std::shared_ptr<void> previousResult;
+
+        for (const auto & m_Element : m_Elements)
+        {
+            // pass to each element in the pipeline
+            m_Element->Process(input, output, previousResult, result, fileID);
+            input = output;
+            previousResult = result;
+        }
+
+        // last element in the pipeline is the localization (or the contours) - save its result
+        contours = std::move(*std::static_pointer_cast<ContourStore>(result));
+    }
+
+    // Propose candidate regions on a coarse level and only pass those regions at full resolution through the pipeline
+    void Pipeline::RunOnRegions(const cv::Mat& image, const std::string& fileID, ContourStore& contours)
+    {
+        cv::Mat input;
+        cv::Mat output;
+
+        std::shared_ptr<void> result;
+        std::shared_ptr<void> previousResult;
+
+        m_RegionProposal->Process(image, output, nullptr, result, fileID);
+        auto regions = std::static_pointer_cast<std::pmr::vector<cv::Rect>>(result);
+
+        // the localizer (last element) runs once over the contours of all the regions in frame coordinates
+        auto frameContours = std::allocate_shared<FumaroleContours>(std::pmr::polymorphic_allocator<FumaroleContours>(m_Arena->Resource()), m_Arena->Resource());
+        const size_t localizerIndex = (m_LastStage == PIPELINE_STAGE_LOCALIZATIONS ? m_Elements.size() - 1 : m_Elements.size());
+
+        for (size_t i = 0; i < regions->size(); i++)
+        {
+            const cv::Rect& region = (*regions)[i];
+
+            // view into the full resolution frame (no copy)
+            input = image(region);
+            previousResult = nullptr;
+
+            // region names are only needed for saving intermediate results
+            const std::string regionID = m_SaveResults ? fileID + "_roi_" + std::to_string(i) : std::string();
+
+            for (size_t e = 0; e < localizerIndex; e++)
             {
-                // pass to each element in the pipeline
-                m_Element->Process(input, output, previousResult, result, file.first);
+                m_Elements[e]->Process(input, output, previousResult, result, m_SaveResults ? regionID : fileID);
                 input = output;
                 previousResult = result;
             }
 
-            // last element in the pipeline is the localization - save its input
-            auto contours = std::static_pointer_cast<std::vector<std::vector<cv::Point>>>(result);
-            m_Localizations[file.first] = std::move(*contours);
+            // map the region contours back to frame coordinates
+            frameContours->Append(*std::static_pointer_cast<FumaroleContours>(result), region.tl());
+        }
 
-            previousResult = nullptr;
+        if (localizerIndex == m_Elements.size()) {
+            contours = std::move(*frameContours);
+            return;
         }
 
-        return true;
+        m_Elements[localizerIndex]->Process(image, output, frameContours, result, fileID);
+        contours = std::move(*std::static_pointer_cast<ContourStore>(result));
+    }
+
+    // Set localization callback
+    void Pipeline::SetLocalizationCallback(LocalizationCallback callback) {
+        m_LocalizationCallback = std::move(callback);
+    }
+
+    // Set failure callback
+    void Pipeline::SetFailureCallback(FailureCallback callback) {
+        m_FailureCallback = std::move(callback);
+    }
+
+    // Set image loader
+    void Pipeline::SetImageLoader(ImageLoader loader) {
+        m_ImageLoader = std::move(loader);
+    }
+
+    // Get the failed images
+    const std::map<std::string, std::string>& Pipeline::GetFailures() const {
+        return m_Failures;
+    }
+
+    // Get the allocation counts of the frame arena
+    const Memory::AllocationStats& Pipeline::GetAllocationStats() const {
+        return m_Arena->Stats();
+    }
+
+    // Get the number of skipped frames
+    int Pipeline::GetSkippedFrameCount() const {
+        return m_SkippedFrames;
     }
 
     // Get final localizations
-    PipelineLocalizations Pipeline::GetLocalizations() const {
+    const PipelineLocalizations& Pipeline::GetLocalizations() const {
         return m_Localizations;
     }
 }
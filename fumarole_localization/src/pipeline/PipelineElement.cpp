@@ -24,6 +24,12 @@ namespace Pipeline
 
     }
 
+    // Set memory resource
+    void PipelineElement::SetMemoryResource(std::pmr::memory_resource* resource)
+    {
+        m_MemoryResource = resource;
+    }
+
     // Write image to disk
     void PipelineElement::SaveResult(const cv::Mat &output, const std::string& filename) const
     {
@@ -0,0 +1,116 @@
+//
+// RegionProposal.cpp
+// Proposes candidate regions of interest for fumaroles on a downsampled pyramid level
+//
+
+#include "pipeline/RegionProposal.hpp"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+namespace Pipeline
+{
+    // Constructor
+    RegionProposal::RegionProposal(const std::string &name, bool saveResults, const Config::PipelineConfig& config) : PipelineElement(name, saveResults)
+    {
+        m_Levels = config.PyramidLevels;
+        m_Padding = config.PyramidRoiPadding;
+
+        // only the lowest heat range matters for finding candidates
+        m_LowestHeatRange = config.LowestHeatRange();
+    }
+
+    // Process
+    void RegionProposal::Process(const cv::Mat& input, cv::Mat& output, const std::shared_ptr<void>& previousElementResult, std::shared_ptr<void>& result, const std::string& filename)
+    {
+        auto regions = std::allocate_shared<std::pmr::vector<cv::Rect>>(std::pmr::polymorphic_allocator<cv::Rect>(m_MemoryResource));
+
+        // downsample to the coarse pyramid level
+        cv::Mat coarse = input;
+        cv::Mat next;
+        for (int i = 0; i < m_Levels; i++) {
+            MaxPoolDown(coarse, next);
+            coarse = next.clone();
+        }
+
+        // band threshold and region extraction on the coarse level
+        cv::Mat mask;
+        cv::threshold(coarse, mask, m_LowestHeatRange, 255, cv::THRESH_BINARY);
+
+        std::vector<std::vector<cv::Point>>& contours = m_FoundContours;
+        cv::findContours(mask, contours, cv::RetrievalModes::RETR_EXTERNAL, cv::ContourApproximationModes::CHAIN_APPROX_SIMPLE);
+
+        // scale the regions up to full resolution and enlarge them by the padding
+        const int scale = 1 << m_Levels;
+        const cv::Rect frame(0, 0, input.cols, input.rows);
+
+        for (const auto& contour : contours)
+        {
+            cv::Rect r = cv::boundingRect(contour);
+            cv::Rect region(r.x * scale - m_Padding, r.y * scale - m_Padding, r.width * scale + 2 * m_Padding, r.height * scale + 2 * m_Padding);
+            regions->emplace_back(region & frame);
+        }
+
+        // overlapping regions are processed as one so no contour is split between them
+        MergeOverlappingRegions(*regions);
+
+        result = regions;
+        output = input;
+
+        // save the regions drawn on the image if required
+        if (m_SaveIntermediateResults)
+        {
+            cv::Mat image = input.clone();
+            for (const cv::Rect& region : *regions) {
+                cv::rectangle(image, region, cv::Scalar(255), 2);
+            }
+            SaveResult(image, filename);
+        }
+    }
+
+    // Downsample by 2 keeping the max of each 2x2 block
+    void RegionProposal::MaxPoolDown(const cv::Mat& input, cv::Mat& output) const
+    {
+        output.create((input.rows + 1) / 2, (input.cols + 1) / 2, CV_8U);
+
+        for (int row = 0; row < output.rows; row++)
+        {
+            const uchar* r0 = input.ptr<uchar>(2 * row);
+            const uchar* r1 = input.ptr<uchar>(std::min(2 * row + 1, input.rows - 1));
+            uchar* out = output.ptr<uchar>(row);
+
+            for (int col = 0; col < output.cols; col++)
+            {
+                const int c0 = 2 * col;
+                const int c1 = std::min(2 * col + 1, input.cols - 1);
+                out[col] = std::max(std::max(r0[c0], r0[c1]), std::max(r1[c0], r1[c1]));
+            }
+        }
+    }
+
+    // Merge the regions that overlap into their enclosing region until none overlap
+    void RegionProposal::MergeOverlappingRegions(std::pmr::vector<cv::Rect>& regions) const
+    {
+        bool merged = true;
+        while (merged)
+        {
+            merged = false;
+            for (size_t i = 0; i < regions.size() && !merged; i++)
+            {
+                for (size_t j = i + 1; j < regions.size(); j++)
+                {
+                    if ((regions[i] & regions[j]).area() > 0)
+                    {
+                        regions[i] |= regions[j];
+                        regions.erase(regions.begin() + j);
+                        merged = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,565 @@
+//
+// DetectionServer.cpp
+// Long-running detection service on a Unix domain socket (local clients only)
+//
+
+#include "server/DetectionServer.hpp"
+#include "detection/DetectorSession.hpp"
+#include "model/FumaroleType.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+namespace Server
+{
+    const int ACCEPT_POLL_MS { 250 };
+    const int LISTEN_BACKLOG { 64 };
+    const uint32_t MAX_PATH_SIZE { 4096 };
+    const uint32_t MAX_FRAME_SIDE { 16384 };
+
+    // a client that stops reading its replies cannot block its connection thread (and so the shutdown) for longer
+    const int SEND_TIMEOUT_SECONDS { 10 };
+
+    // Read exactly size bytes (false on end of stream or error)
+    static bool ReadExact(int socket, void* buffer, size_t size)
+    {
+        auto* bytes = static_cast<char*>(buffer);
+        while (size > 0)
+        {
+            const ssize_t count = ::read(socket, bytes, size);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return false;
+            }
+
+            bytes += count;
+            size -= static_cast<size_t>(count);
+        }
+
+        return true;
+    }
+
+    // Write exactly size bytes
+    static bool WriteExact(int socket, const void* buffer, size_t size)
+    {
+        const auto* bytes = static_cast<const char*>(buffer);
+        while (size > 0)
+        {
+            const ssize_t count = ::write(socket, bytes, size);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return false;
+            }
+
+            bytes += count;
+            size -= static_cast<size_t>(count);
+        }
+
+        return true;
+    }
+
+    // Write a reply with its size prefix
+    static bool WriteReply(int socket, const std::string& reply)
+    {
+        const uint32_t size = static_cast<uint32_t>(reply.size());
+        return WriteExact(socket, &size, sizeof(size)) && WriteExact(socket, reply.data(), reply.size());
+    }
+
+    // Quote a string for JSON
+    static std::string JsonString(const std::string& text)
+    {
+        std::string quoted { "\"" };
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\') {
+                quoted += '\\';
+                quoted += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20) {
+                quoted += ' ';
+            }
+            else {
+                quoted += c;
+            }
+        }
+
+        return quoted + "\"";
+    }
+
+    // Constructor
+    DetectionServer::DetectionServer(const Config::DetectorConfig& config, std::string socketPath) :
+        m_Config(config), m_SocketPath(std::move(socketPath))
+    {
+
+    }
+
+    // Destructor
+    DetectionServer::~DetectionServer()
+    {
+        Stop();
+        Shutdown();
+    }
+
+    // Start
+    bool DetectionServer::Start()
+    {
+        sockaddr_un address {};
+        if (m_SocketPath.empty() || m_SocketPath.size() >= sizeof(address.sun_path)) {
+            std::cerr << "\nInvalid socket path: " << m_SocketPath << std::endl;
+            return false;
+        }
+
+        // a client that disconnects before its reply must not end the server
+        std::signal(SIGPIPE, SIG_IGN);
+
+        // replace the socket of a previous server (but no other kind of file)
+        struct stat status {};
+        if (::stat(m_SocketPath.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+            ::unlink(m_SocketPath.c_str());
+        }
+
+        m_ListenSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (m_ListenSocket < 0) {
+            std::cerr << "\nFailed to create socket: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, m_SocketPath.c_str(), sizeof(address.sun_path) - 1);
+
+        // only processes of the same user (and group) can connect: the socket is created with these permissions
+        // (rw-rw----) rather than changed after binding, so there is no moment where others could connect
+        const mode_t previousMask = ::umask(S_IXUSR | S_IXGRP | S_IRWXO);
+        const bool bound = (::bind(m_ListenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+        const int bindError = errno;
+        ::umask(previousMask);
+
+        if (!bound || ::listen(m_ListenSocket, LISTEN_BACKLOG) < 0)
+        {
+            std::cerr << "\nFailed to listen on " << m_SocketPath << ": " << std::strerror(bound ? errno : bindError) << std::endl;
+            ::close(m_ListenSocket);
+            m_ListenSocket = -1;
+            return false;
+        }
+
+        m_StartTime = std::chrono::steady_clock::now();
+        m_WorkersStopping = false;
+        for (int i = 0; i < m_Config.Server.Workers; i++) {
+            m_Workers.emplace_back(&DetectionServer::RunWorker, this);
+        }
+
+        return true;
+    }
+
+    // Accept connections
+    void DetectionServer::Run()
+    {
+        pollfd listening {};
+        listening.fd = m_ListenSocket;
+        listening.events = POLLIN;
+
+        while (!m_Stopping && m_ListenSocket >= 0)
+        {
+            // the timeout lets a stop request be noticed without a connection
+            const int ready = ::poll(&listening, 1, ACCEPT_POLL_MS);
+
+            CloseConnections(true);
+
+            if (ready <= 0 || m_Stopping) {
+                continue;
+            }
+
+            const int socket = ::accept(m_ListenSocket, nullptr, nullptr);
+            if (socket < 0) {
+                continue;
+            }
+
+            timeval sendTimeout {};
+            sendTimeout.tv_sec = SEND_TIMEOUT_SECONDS;
+            ::setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+
+            std::lock_guard<std::mutex> lock(m_ConnectionsMutex);
+
+            // each connection has a thread and can hold a frame, so their number bounds the memory of the clients
+            // (the finished ones were closed above)
+            if (m_Connections.size() >= static_cast<size_t>(m_Config.Server.MaxConnections))
+            {
+                m_RefusedConnections++;
+                WriteReply(socket, ErrorReply("Too many connections"));
+                ::close(socket);
+                continue;
+            }
+
+            m_Connections.emplace_back(std::make_unique<Connection>());
+            Connection& connection = *m_Connections.back();
+            connection.Socket = socket;
+            connection.Thread = std::thread(&DetectionServer::Serve, this, std::ref(connection));
+        }
+
+        Shutdown();
+    }
+
+    // Stop
+    void DetectionServer::Stop() {
+        m_Stopping = true;
+    }
+
+    // Stats
+    ServerStats DetectionServer::GetStats() const
+    {
+        ServerStats stats;
+        stats.Requests = m_Requests;
+        stats.Frames = m_Frames;
+        stats.Failures = m_Failures;
+        stats.Batches = m_Batches;
+        stats.RefusedConnections = m_RefusedConnections;
+        stats.UptimeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_StartTime).count();
+
+        {
+            std::lock_guard<std::mutex> lock(m_QueueMutex);
+            stats.QueueDepth = m_Queue.size();
+            stats.MaxQueueDepth = m_MaxQueueDepth;
+        }
+
+        std::lock_guard<std::mutex> lock(m_ConnectionsMutex);
+        stats.Connections = static_cast<size_t>(std::count_if(m_Connections.begin(), m_Connections.end(), [](const std::unique_ptr<Connection>& c) { return !c->Done; }));
+
+        return stats;
+    }
+
+    // Answer the requests of a connection one after another
+    void DetectionServer::Serve(Connection& connection)
+    {
+        while (!m_Stopping)
+        {
+            std::unique_ptr<Job> job;
+            std::string error;
+
+            if (!ReadRequest(connection.Socket, job, error))
+            {
+                // the stream cannot be resynchronized after an invalid request
+                if (!error.empty()) {
+                    WriteReply(connection.Socket, ErrorReply(error));
+                }
+                break;
+            }
+
+            m_Requests++;
+
+            const std::string reply = (job->Type == REQUEST_STATS ? StatsReply(GetStats()) : Submit(std::move(job)));
+            if (!WriteReply(connection.Socket, reply)) {
+                break;
+            }
+        }
+
+        // the socket is closed when the thread is joined
+        connection.Done = true;
+    }
+
+    // Read a request
+    bool DetectionServer::ReadRequest(int socket, std::unique_ptr<Job>& job, std::string& error) const
+    {
+        uint32_t header[2];
+        if (!ReadExact(socket, header, sizeof(header))) {
+            return false;
+        }
+
+        const uint32_t type = header[0];
+        const uint32_t size = header[1];
+
+        job = std::make_unique<Job>();
+
+        if (type == REQUEST_STATS && size == 0) {
+            job->Type = REQUEST_STATS;
+            return true;
+        }
+
+        if (type == REQUEST_PATH)
+        {
+            if (size == 0 || size > MAX_PATH_SIZE) {
+                error = "Invalid path size " + std::to_string(size);
+                return false;
+            }
+
+            job->Type = REQUEST_PATH;
+            job->Path.resize(size);
+
+            if (!ReadExact(socket, &job->Path[0], size)) {
+                error = "Truncated request";
+                return false;
+            }
+
+            return true;
+        }
+
+        if (type == REQUEST_FRAME)
+        {
+            uint32_t dimensions[2];
+            if (size < sizeof(dimensions) || !ReadExact(socket, dimensions, sizeof(dimensions))) {
+                error = "Truncated request";
+                return false;
+            }
+
+            const uint32_t width = dimensions[0];
+            const uint32_t height = dimensions[1];
+
+            // the frame is allocated before its pixels arrive, so its size is checked against the limit first
+            const uint64_t frameBytes = static_cast<uint64_t>(width) * height;
+            if (width == 0 || height == 0 || width > MAX_FRAME_SIDE || height > MAX_FRAME_SIDE || frameBytes > m_Config.Server.MaxFrameBytes || static_cast<uint64_t>(size) != sizeof(dimensions) + frameBytes) {
+                error = "Invalid frame of " + std::to_string(width) + "x" + std::to_string(height) + " in " + std::to_string(size) + " bytes";
+                return false;
+            }
+
+            // the pixels are read straight into the frame
+            job->Type = REQUEST_FRAME;
+            job->Frame.create(static_cast<int>(height), static_cast<int>(width), CV_8UC1);
+
+            if (!ReadExact(socket, job->Frame.data, static_cast<size_t>(frameBytes))) {
+                error = "Truncated request";
+                return false;
+            }
+
+            return true;
+        }
+
+        error = "Unknown request type " + std::to_string(type);
+        return false;
+    }
+
+    // Queue a request for the workers and wait for its reply
+    std::string DetectionServer::Submit(std::unique_ptr<Job> job)
+    {
+        std::future<std::string> reply = job->Reply.get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(m_QueueMutex);
+
+            if (m_WorkersStopping) {
+                return ErrorReply("Server is stopping");
+            }
+
+            m_Queue.push_back(std::move(job));
+            m_MaxQueueDepth = std::max(m_MaxQueueDepth, m_Queue.size());
+        }
+
+        m_QueueCondition.notify_one();
+
+        return reply.get();
+    }
+
+    // Detect the queued requests in batches
+    void DetectionServer::RunWorker()
+    {
+        // the session keeps its pipeline and buffers for all the frames of this worker
+        Detection::DetectorSession session(m_Config);
+        std::vector<Detection::FumaroleDetection> detections;
+        std::vector<std::unique_ptr<Job>> batch;
+
+        while (true)
+        {
+            bool wakeAnother = false;
+
+            {
+                std::unique_lock<std::mutex> lock(m_QueueMutex);
+
+                m_IdleWorkers++;
+                m_QueueCondition.wait(lock, [&]() { return m_WorkersStopping || !m_Queue.empty(); });
+
+                // this worker and the other idle ones share the queue, so a batch only grows past one request while
+                // there are more requests than idle workers (a batch never delays a request another worker could start)
+                const size_t idleWorkers = static_cast<size_t>(m_IdleWorkers);
+                m_IdleWorkers--;
+
+                // the queue is drained before stopping so every waiting connection gets its reply
+                if (m_Queue.empty()) {
+                    return;
+                }
+
+                const size_t share = (m_Queue.size() + idleWorkers - 1) / idleWorkers;
+                const size_t batchSize = std::min(share, static_cast<size_t>(m_Config.Server.MaxBatchSize));
+
+                while (!m_Queue.empty() && batch.size() < batchSize)
+                {
+                    batch.push_back(std::move(m_Queue.front()));
+                    m_Queue.pop_front();
+                }
+
+                wakeAnother = (!m_Queue.empty() && m_IdleWorkers > 0);
+            }
+
+            if (wakeAnother) {
+                m_QueueCondition.notify_one();
+            }
+
+            m_Batches++;
+
+            for (const std::unique_ptr<Job>& job : batch)
+            {
+                try
+                {
+                    cv::Mat frame = job->Frame;
+                    if (job->Type == REQUEST_PATH) {
+                        frame = cv::imread(job->Path, cv::IMREAD_GRAYSCALE);
+                    }
+
+                    if (!frame.data)
+                    {
+                        m_Failures++;
+                        job->Reply.set_value(ErrorReply("Failed to read file: " + job->Path));
+                    }
+                    else if (!session.Detect(frame, detections))
+                    {
+                        m_Failures++;
+                        job->Reply.set_value(ErrorReply("Failed to process frame"));
+                    }
+                    else
+                    {
+                        m_Frames++;
+                        job->Reply.set_value(DetectionsReply(detections));
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    m_Failures++;
+                    job->Reply.set_value(ErrorReply(e.what()));
+                }
+            }
+
+            batch.clear();
+        }
+    }
+
+    // Join connection threads and close their sockets
+    void DetectionServer::CloseConnections(bool finishedOnly)
+    {
+        std::list<std::unique_ptr<Connection>> closing;
+
+        {
+            std::lock_guard<std::mutex> lock(m_ConnectionsMutex);
+            for (auto iter = m_Connections.begin(); iter != m_Connections.end();)
+            {
+                if (!finishedOnly || (*iter)->Done) {
+                    closing.splice(closing.end(), m_Connections, iter++);
+                }
+                else {
+                    iter++;
+                }
+            }
+        }
+
+        for (const std::unique_ptr<Connection>& connection : closing)
+        {
+            if (connection->Thread.joinable()) {
+                connection->Thread.join();
+            }
+
+            ::close(connection->Socket);
+        }
+    }
+
+    // Stop listening, finish the queued requests and close all connections
+    void DetectionServer::Shutdown()
+    {
+        if (m_ListenSocket >= 0)
+        {
+            ::close(m_ListenSocket);
+            ::unlink(m_SocketPath.c_str());
+            m_ListenSocket = -1;
+        }
+
+        // unblock the connections waiting for their next request (their sockets stay open until joined),
+        // the ones waiting for a reply still get it from the workers below
+        {
+            std::lock_guard<std::mutex> lock(m_ConnectionsMutex);
+            for (const std::unique_ptr<Connection>& connection : m_Connections) {
+                ::shutdown(connection->Socket, SHUT_RD);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_QueueMutex);
+            m_WorkersStopping = true;
+        }
+
+        m_QueueCondition.notify_all();
+
+        for (std::thread& worker : m_Workers) {
+            worker.join();
+        }
+
+        m_Workers.clear();
+
+        // unblock the connections still writing a reply to a client that stopped reading
+        {
+            std::lock_guard<std::mutex> lock(m_ConnectionsMutex);
+            for (const std::unique_ptr<Connection>& connection : m_Connections) {
+                ::shutdown(connection->Socket, SHUT_RDWR);
+            }
+        }
+
+        CloseConnections(false);
+    }
+
+    // Reply with the detections of a frame
+    std::string DetectionServer::DetectionsReply(const std::vector<Detection::FumaroleDetection>& detections)
+    {
+        std::ostringstream ss;
+        ss << "{\"status\":\"ok\",\"detections\":[";
+
+        for (size_t i = 0; i < detections.size(); i++)
+        {
+            const Detection::FumaroleDetection& d = detections[i];
+
+            ss << (i > 0 ? "," : "");
+            ss << "{\"type\":" << JsonString(Model::TypeNameString(d.Type));
+            ss << ",\"score\":" << d.Score;
+            ss << ",\"x\":" << d.BoundingBox.x << ",\"y\":" << d.BoundingBox.y;
+            ss << ",\"width\":" << d.BoundingBox.width << ",\"height\":" << d.BoundingBox.height << "}";
+        }
+
+        ss << "]}";
+
+        return ss.str();
+    }
+
+    // Reply with an error
+    std::string DetectionServer::ErrorReply(const std::string& message) {
+        return "{\"status\":\"error\",\"message\":" + JsonString(message) + "}";
+    }
+
+    // Reply with the server stats
+    std::string DetectionServer::StatsReply(const ServerStats& stats)
+    {
+        std::ostringstream ss;
+        ss << "{\"status\":\"ok\",\"stats\":{";
+        ss << "\"requests\":" << stats.Requests;
+        ss << ",\"frames\":" << stats.Frames;
+        ss << ",\"failures\":" << stats.Failures;
+        ss << ",\"batches\":" << stats.Batches;
+        ss << ",\"average_batch_size\":" << stats.AverageBatchSize();
+        ss << ",\"queue_depth\":" << stats.QueueDepth;
+        ss << ",\"max_queue_depth\":" << stats.MaxQueueDepth;
+        ss << ",\"connections\":" << stats.Connections;
+        ss << ",\"refused_connections\":" << stats.RefusedConnections;
+        ss << ",\"uptime_seconds\":" << stats.UptimeSeconds;
+        ss << ",\"frames_per_second\":" << stats.FramesPerSecond();
+        ss << "}}";
+
+        return ss.str();
+    }
+}
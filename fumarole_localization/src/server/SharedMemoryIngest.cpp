@@ -0,0 +1,147 @@
+//
+// SharedMemoryIngest.cpp
+// Detects the frames of a shared memory frame ring and writes the detections into a result ring
+//
+
+#include "server/SharedMemoryIngest.hpp"
+
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+namespace Server
+{
+    // rounds of yielding before sleeping while a ring is empty (or full)
+    const int SPIN_ROUNDS { 64 };
+    const std::chrono::microseconds IDLE_SLEEP { 200 };
+
+    // Constructor
+    SharedMemoryIngest::SharedMemoryIngest(const Config::DetectorConfig& config, std::string frameRingName, std::string resultRingName) :
+        m_Session(config), m_FrameRingName(std::move(frameRingName)), m_ResultRingName(std::move(resultRingName))
+    {
+
+    }
+
+    // Start
+    bool SharedMemoryIngest::Start()
+    {
+        if (!m_Frames.Open(m_FrameRingName)) {
+            return false;
+        }
+
+        if (m_Frames.GetSlotSize() < sizeof(IO::FrameSlot))
+        {
+            std::cerr << "\nThe slots of " << m_FrameRingName << " are too small for a frame" << std::endl;
+            return false;
+        }
+
+        // a result slot for each frame slot so a result can always be written for a frame in flight
+        return m_Results.Create(m_ResultRingName, m_Frames.GetSlotCount(), sizeof(IO::ResultSlot));
+    }
+
+    // Run
+    void SharedMemoryIngest::Run()
+    {
+        int idleRounds = 0;
+
+        while (!m_Stopping)
+        {
+            const auto* frame = static_cast<const IO::FrameSlot*>(m_Frames.BeginRead());
+            if (frame == nullptr) {
+                Wait(idleRounds);
+                continue;
+            }
+
+            // the result ring is only full if the reader of the results fell behind
+            void* slot = m_Results.BeginWrite();
+            if (slot == nullptr) {
+                Wait(idleRounds);
+                continue;
+            }
+
+            idleRounds = 0;
+
+            auto* result = static_cast<IO::ResultSlot*>(slot);
+            DetectSlot(*frame, *result);
+
+            m_Results.EndWrite();
+            m_Frames.EndRead();
+        }
+    }
+
+    // Stop
+    void SharedMemoryIngest::Stop() {
+        m_Stopping = true;
+    }
+
+    // Stats
+    const IngestStats& SharedMemoryIngest::GetStats() const {
+        return m_Stats;
+    }
+
+    // Latencies
+    Detection::LatencySummary SharedMemoryIngest::GetLatencySummary() const {
+        return m_Session.GetLatencySummary();
+    }
+
+    // Detect the frame of a slot and fill in its result
+    bool SharedMemoryIngest::DetectSlot(const IO::FrameSlot& frame, IO::ResultSlot& result)
+    {
+        result.Sequence = frame.Sequence;
+        result.Timestamp = frame.Timestamp;
+        result.Status = IO::RESULT_FAILED;
+        result.Count = 0;
+
+        // the pixels must lie within the slot
+        const uint64_t pixelBytes = static_cast<uint64_t>(frame.Stride) * frame.Height;
+        if (sizeof(IO::FrameSlot) + pixelBytes > m_Frames.GetSlotSize())
+        {
+            std::cerr << "\nFrame " << frame.Sequence << " is larger than its slot" << std::endl;
+            m_Stats.Failures++;
+            return false;
+        }
+
+        // detected in place (no copy of the pixels)
+        const auto* pixels = reinterpret_cast<const uint8_t*>(&frame + 1);
+        if (!m_Session.Detect(pixels, static_cast<int>(frame.Width), static_cast<int>(frame.Height), frame.Stride, m_Detections)) {
+            m_Stats.Failures++;
+            return false;
+        }
+
+        m_Stats.Frames++;
+
+        result.Count = static_cast<uint32_t>(std::min<size_t>(m_Detections.size(), IO::MAX_RESULT_DETECTIONS));
+        result.Status = (m_Detections.size() > IO::MAX_RESULT_DETECTIONS ? IO::RESULT_TRUNCATED : IO::RESULT_OK);
+
+        if (result.Status == IO::RESULT_TRUNCATED) {
+            m_Stats.TruncatedResults++;
+        }
+
+        for (uint32_t i = 0; i < result.Count; i++)
+        {
+            const Detection::FumaroleDetection& detection = m_Detections[i];
+
+            IO::ResultDetection& out = result.Detections[i];
+            out.Type = static_cast<int32_t>(detection.Type);
+            out.Score = detection.Score;
+            out.X = detection.BoundingBox.x;
+            out.Y = detection.BoundingBox.y;
+            out.Width = detection.BoundingBox.width;
+            out.Height = detection.BoundingBox.height;
+        }
+
+        return true;
+    }
+
+    // Back off while there is nothing to do (yield first for low latency, then sleep to free the core)
+    void SharedMemoryIngest::Wait(int& idleRounds) const
+    {
+        if (idleRounds < SPIN_ROUNDS) {
+            idleRounds++;
+            std::this_thread::yield();
+        }
+        else {
+            std::this_thread::sleep_for(IDLE_SLEEP);
+        }
+    }
+}
@@ -0,0 +1,103 @@
+// sweep.cpp
+// Parameter sweep program for tuning the contour and classification params against the ground truth dataset
+
+#include "io/DatasetLoader.hpp"
+#include "evaluation/ParameterSweep.hpp"
+#include "config/ConfigParser.hpp"
+
+#include <map>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+
+const std::string DEFAULT_FOLDER { "test_set_4/" };
+const std::string SWEEP_RESULTS_FILE_NAME { "sweep_results.csv" };
+
+std::vector<float> GetSweepValues(const std::string& name, const std::string& currentValuePath);
+
+int main(int argc, char** argv)
+{
+    // optional param is the test set folder
+    std::string folder { DEFAULT_FOLDER };
+    if (argc > 1) {
+        folder = argv[1];
+    }
+
+    // Load test files and ground truth
+    std::map<std::string, std::string> testFiles;
+    std::map<std::string, std::vector<Detection::FumaroleDetection>> groundTruth;
+    IO::DatasetLoader::LoadTestData(folder, testFiles, groundTruth);
+
+    // grid values (the current config value if no values are given for a param)
+    std::vector<float> minAreas = GetSweepValues("min_area", "config.pipeline.contour.min_area");
+    std::vector<float> minAreasHeatedArea = GetSweepValues("min_area_heated_area", "config.detection.min_area_heated_area");
+    std::vector<float> openVentRadii = GetSweepValues("open_vent_radius_search", "config.detection.open_vent_radius_search");
+    std::vector<float> hiddenVentRadii = GetSweepValues("hidden_area_radius_search", "config.detection.hidden_area_radius_search");
+
+    // run sweep
+    Evaluation::ParameterSweep sweep(testFiles, groundTruth, Config::ConfigParser::GetInstance().GetDetectorConfig());
+    std::vector<Evaluation::SweepResult> results;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!sweep.Run(minAreas, minAreasHeatedArea, openVentRadii, hiddenVentRadii, results)) {
+        return 1;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // print out the grid points from best to worst avg IoU
+    std::sort(results.begin(), results.end(), [](const Evaluation::SweepResult& r1, const Evaluation::SweepResult& r2){ return r1.AverageIoU > r2.AverageIoU; });
+
+    std::cout << "\n\n--------------- Parameter Sweep ---------------\n";
+    std::cout << std::setw(10) << std::setfill(' ') << "\nMin Area";
+    std::cout << std::setw(14) << std::setfill(' ') << "Heated Area";
+    std::cout << std::setw(14) << std::setfill(' ') << "Open Radius";
+    std::cout << std::setw(14) << std::setfill(' ') << "Hidden Radius";
+    std::cout << std::setw(12) << std::setfill(' ') << "Avg IoU";
+    std::cout << std::setw(12) << std::setfill(' ') << "Class Acc %";
+    std::cout << std::setw(10) << std::setfill(' ') << "Detected";
+    std::cout << std::setw(10) << std::setfill(' ') << "Actual";
+    std::cout << std::endl;
+
+    for (const Evaluation::SweepResult& r : results)
+    {
+        std::cout << std::setw(10) << std::setfill(' ') << r.Parameters.MinArea;
+        std::cout << std::setw(14) << std::setfill(' ') << r.Parameters.MinAreaHeatedArea;
+        std::cout << std::setw(14) << std::setfill(' ') << r.Parameters.OpenVentRadius;
+        std::cout << std::setw(14) << std::setfill(' ') << r.Parameters.HiddenVentRadius;
+        std::cout << std::setw(12) << std::setfill(' ') << r.AverageIoU;
+        std::cout << std::setw(12) << std::setfill(' ') << r.ClassificationAccuracy * 100;
+        std::cout << std::setw(10) << std::setfill(' ') << r.TotalNumberDetected;
+        std::cout << std::setw(10) << std::setfill(' ') << r.TotalNumberOfActualFumaroles;
+        std::cout << std::endl;
+    }
+
+    std::cout << "\nSweep time (ms) = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << std::endl;
+
+    // save to csv
+    Evaluation::ParameterSweep::SaveResultsToCSV(SWEEP_RESULTS_FILE_NAME, results);
+    std::cout << "\nSaved sweep results to " << SWEEP_RESULTS_FILE_NAME << std::endl;
+
+    return 0;
+}
+
+// Get the space separated values of a param from the sweep section of the config
+std::vector<float> GetSweepValues(const std::string& name, const std::string& currentValuePath)
+{
+    std::string currentValue = Config::ConfigParser::GetInstance().GetValue<std::string>(currentValuePath);
+    std::string values = Config::ConfigParser::GetInstance().GetValue<std::string>("config.sweep." + name, currentValue);
+
+    std::vector<std::string> valueStrings;
+    boost::trim(values);
+    boost::split(valueStrings, values, boost::is_space(), boost::token_compress_on);
+
+    std::vector<float> sweepValues;
+    for (const std::string& value : valueStrings) {
+        sweepValues.push_back(std::stof(value));
+    }
+
+    return sweepValues;
+}
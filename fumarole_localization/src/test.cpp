@@ -3,30 +3,80 @@
 
 #include "io/DatasetLoader.hpp"
 #include "detection/FumaroleDetector.hpp"
+#include "detection/DetectorSession.hpp"
 #include "evaluation/Evaluation.hpp"
 #include "evaluation/AlgorithmEvaluator.hpp"
+#include "config/ConfigParser.hpp"
+#include "io/ImageCache.hpp"
 
 #include <map>
 #include <vector>
 #include <iostream>
 #include <iomanip>
 #include <numeric>
+#include <chrono>
+#include <future>
+#include <fstream>
 #include <boost/filesystem.hpp>
+#include <opencv2/highgui/highgui.hpp>
 
 const std::string FOLDER { "test_set_4/" };
 const std::string CSV_SAVE_FOLDER { "confusion_matrix" };
 const std::string DETECTION_METRICS_SAVE_FOLDER { "detection_metrics" };
 const std::string IOU_METRICS_SAVE_FOLDER { "iou_metrics" };
+const std::string PR_CURVES_SAVE_FOLDER { "pr_curves" };
 const std::string CONFUSION_MATRIX_FILE_NAME { "classification_confusion_matrix" };
+const std::vector<std::string> TEST_SETS { "test_set_1/", "test_set_2/", "test_set_3/", "test_set_4/" };
+const std::string CROSS_VALIDATION_FILE_NAME { "cross_validation.csv" };
+const int LATENCY_WARMUP_FRAMES { 10 };
+const int LATENCY_PASSES { 5 };
+const size_t IMAGE_CACHE_MAX_BYTES { 1ull << 30 };
 
 // Eval functions for detector and classifier
 void EvaluateDetector(const Evaluation::AlgorithmEvaluation& evaluation);
 void EvaluateClassifier(const Evaluation::AlgorithmEvaluation& evaluation);
 void SaveConfusionMatrices(const Evaluation::AlgorithmEvaluation& evaluation);
 void SaveDetectionsMetrics(const Evaluation::AlgorithmEvaluation& evaluation);
+void ComparePyramidDetection();
+int RunEvaluationShard(int shardIndex, int shardCount, const std::string& shardPath);
+int MergeEvaluationShards(const std::vector<std::string>& shardPaths);
+int CrossValidate(std::vector<std::string> folders);
+int MeasureSessionLatency(const std::string& folder);
 
 int main(int argc, char** argv)
 {
+    // compare the coarse-to-fine pyramid mode against the full resolution pipeline
+    if (argc > 1 && std::string(argv[1]) == "--compare-pyramid") {
+        ComparePyramidDetection();
+        return 0;
+    }
+
+    // evaluate every n-th image of the test set and save the (unfinalized) evaluation to be merged later
+    if (argc > 1 && std::string(argv[1]) == "--shard")
+    {
+        if (argc != 5) {
+            std::cerr << "Usage: " << argv[0] << " --shard <index> <count> <shard file>" << std::endl;
+            return 1;
+        }
+
+        return RunEvaluationShard(std::stoi(argv[2]), std::stoi(argv[3]), argv[4]);
+    }
+
+    // run and evaluate several test sets at once (all of them if none are given)
+    if (argc > 1 && std::string(argv[1]) == "--cross-validate") {
+        return CrossValidate(std::vector<std::string>(argv + 2, argv + argc));
+    }
+
+    // per-frame latency of a long-lived detector session on the decoded frames of a test set
+    if (argc > 1 && std::string(argv[1]) == "--latency") {
+        return MeasureSessionLatency(argc > 2 ? argv[2] : FOLDER);
+    }
+
+    // merge evaluation shards and report as if the whole test set was evaluated in one run
+    if (argc > 1 && std::string(argv[1]) == "--merge-shards") {
+        return MergeEvaluationShards(std::vector<std::string>(argv + 2, argv + argc));
+    }
+
     // Load test files and ground truth
     std::map<std::string, std::string> testFiles;
     std::map<std::string, std::vector<Detection::FumaroleDetection>> groundTruth;
@@ -83,6 +133,15 @@ void EvaluateDetector(const Evaluation::AlgorithmEvaluation& evaluation)
     }
     std::cout << std::endl;
 
+    // one-to-one matching (COCO-style average precision)
+    std::cout << "\nmAP@[.5:.95] = " << evaluation.Matching.MeanAveragePrecision;
+    std::cout << "\nmAP@.5 = " << evaluation.Matching.MeanAveragePrecision50;
+    std::cout << "\nmAP@.75 = " << evaluation.Matching.MeanAveragePrecision75;
+    for (const auto& c : evaluation.Matching.Classes) {
+        std::cout << "\nAP " << Model::TypeNameString(c.first) << " = " << c.second.AveragePrecision << " (" << c.second.NumberDetected << " detections, " << c.second.NumberOfActualFumaroles << " actual)";
+    }
+    std::cout << std::endl;
+
     // print out individual results
     std::cout << "\n--------------- Image Evaluation ---------------\n";
     std::cout << std::setw(12) << std::setfill(' ') << "\nImage ID";
@@ -119,6 +178,11 @@ void EvaluateClassifier(const Evaluation::AlgorithmEvaluation& evaluation)
     std::cout << "\n\n--------------- Classifier Evaluation ---------------\n";
     std::cout << "\nOverall Accuracy Rate (%) = " << evaluation.ConfusionMatrix.GetAccuracy() * 100;
     std::cout << "\nOverall Misclassification Rate (%) = " << (1.0 - evaluation.ConfusionMatrix.GetAccuracy()) * 100;
+    for (int i = 0; i < Evaluation::ConfusionMatrix::NUMBER_OF_CLASSES; i++)
+    {
+        const Model::FumaroleType type = static_cast<Model::FumaroleType>(i);
+        std::cout << "\n" << Model::TypeNameString(type) << ": precision = " << evaluation.ConfusionMatrix.GetPrecision(type) << ", recall = " << evaluation.ConfusionMatrix.GetRecall(type);
+    }
     std::cout << std::endl;
 
     // print out individual results per image
@@ -201,4 +265,305 @@ void SaveDetectionsMetrics(const Evaluation::AlgorithmEvaluation& evaluation)
 
     filePath = IOU_METRICS_SAVE_FOLDER + "/total_metrics.csv";
     Evaluation::AlgorithmEvaluator::SaveIoUEvaluationMetricsToCSV(filePath, evaluation.IoUDetectionMetrics);
+
+    // save precision recall curves
+    if (!boost::filesystem::exists(PR_CURVES_SAVE_FOLDER)) {
+        boost::filesystem::create_directories(PR_CURVES_SAVE_FOLDER);
+    }
+
+    Evaluation::AlgorithmEvaluator::SavePrecisionRecallCurvesToCSV(PR_CURVES_SAVE_FOLDER + "/", evaluation.Matching);
+}
+
+// Run the full resolution and the coarse-to-fine pyramid pipelines on all the test sets and compare the evaluations
+void ComparePyramidDetection()
+{
+    std::cout << "\n--------------- Full Resolution vs Pyramid ---------------\n";
+    std::cout << std::setw(14) << std::setfill(' ') << "\nTest Set";
+    std::cout << std::setw(10) << std::setfill(' ') << "Mode";
+    std::cout << std::setw(12) << std::setfill(' ') << "Avg IoU";
+    std::cout << std::setw(12) << std::setfill(' ') << "Class Acc %";
+    std::cout << std::setw(10) << std::setfill(' ') << "Detected";
+    std::cout << std::setw(10) << std::setfill(' ') << "Actual";
+    std::cout << std::setw(12) << std::setfill(' ') << "Time (ms)";
+    std::cout << std::endl;
+
+    Evaluation::AlgorithmEvaluator evaluator;
+
+    // both modes run on the same images, each is only decoded once
+    IO::ImageCache imageCache(Config::ConfigParser::GetInstance().GetValue<size_t>("config.cache.max_image_bytes", IMAGE_CACHE_MAX_BYTES));
+
+    for (const std::string& folder : TEST_SETS)
+    {
+        std::map<std::string, std::string> testFiles;
+        std::map<std::string, std::vector<Detection::FumaroleDetection>> groundTruth;
+        IO::DatasetLoader::LoadTestData(folder, testFiles, groundTruth);
+
+        for (bool pyramid : { false, true })
+        {
+            // each mode runs with its own copy of the config
+            Config::DetectorConfig config = Config::ConfigParser::GetInstance().GetDetectorConfig();
+            config.Pipeline.PyramidEnabled = pyramid;
+
+            std::map<std::string, std::vector<Detection::FumaroleDetection>> results;
+            Detection::FumaroleDetector detector(config, false);
+            detector.SetImageLoader([&](const std::string& path, cv::Mat& image) { return imageCache.Load(path, image); });
+
+            auto start = std::chrono::steady_clock::now();
+            detector.DetectFumaroles(testFiles, results);
+            auto end = std::chrono::steady_clock::now();
+
+            Evaluation::AlgorithmEvaluation eval = evaluator.EvaluateDetectionPipeline(results, groundTruth);
+
+            std::cout << std::setw(14) << std::setfill(' ') << folder;
+            std::cout << std::setw(10) << std::setfill(' ') << (pyramid ? "pyramid" : "full");
+            std::cout << std::setw(12) << std::setfill(' ') << eval.TotalAverageIoU;
+            std::cout << std::setw(12) << std::setfill(' ') << eval.ConfusionMatrix.GetAccuracy() * 100;
+            std::cout << std::setw(10) << std::setfill(' ') << eval.TotalNumberDetected;
+            std::cout << std::setw(10) << std::setfill(' ') << eval.TotalNumberOfActualFumaroles;
+            std::cout << std::setw(12) << std::setfill(' ') << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+            std::cout << std::endl;
+        }
+    }
+}
+
+// Evaluate a shard of the test set
+int RunEvaluationShard(int shardIndex, int shardCount, const std::string& shardPath)
+{
+    if (shardCount < 1 || shardIndex < 0 || shardIndex >= shardCount) {
+        std::cerr << "Invalid shard " << shardIndex << " of " << shardCount << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, std::string> allFiles;
+    std::map<std::string, std::vector<Detection::FumaroleDetection>> allGroundTruth;
+    IO::DatasetLoader::LoadTestData(FOLDER, allFiles, allGroundTruth);
+
+    // every n-th image (in the order of the IDs) belongs to this shard
+    std::map<std::string, std::string> testFiles;
+    std::map<std::string, std::vector<Detection::FumaroleDetection>> groundTruth;
+
+    int position = 0;
+    for (const auto& y : allGroundTruth)
+    {
+        if (position++ % shardCount != shardIndex) {
+            continue;
+        }
+
+        groundTruth.insert(y);
+
+        auto iter = allFiles.find(y.first);
+        if (iter != allFiles.end()) {
+            testFiles.insert(*iter);
+        }
+    }
+
+    std::map<std::string, std::vector<Detection::FumaroleDetection>> results;
+    Detection::FumaroleDetector detector(false);
+    detector.DetectFumaroles(testFiles, results);
+
+    Evaluation::AlgorithmEvaluator evaluator;
+    Evaluation::EvaluationAccumulator accumulator = evaluator.AccumulateDetectionPipeline(results, groundTruth);
+
+    if (!accumulator.Save(shardPath)) {
+        return 1;
+    }
+
+    std::cout << "\nSaved evaluation of " << groundTruth.size() << " images to " << shardPath << std::endl;
+    return 0;
+}
+
+// Merge evaluation shards
+int MergeEvaluationShards(const std::vector<std::string>& shardPaths)
+{
+    if (shardPaths.empty()) {
+        std::cerr << "No evaluation shards to merge" << std::endl;
+        return 1;
+    }
+
+    Evaluation::EvaluationAccumulator accumulator;
+    for (const std::string& path : shardPaths)
+    {
+        Evaluation::EvaluationAccumulator shard;
+        if (!shard.Load(path)) {
+            return 1;
+        }
+
+        accumulator.Merge(shard);
+    }
+
+    Evaluation::AlgorithmEvaluation eval = accumulator.Finalize();
+
+    EvaluateDetector(eval);
+    EvaluateClassifier(eval);
+    SaveDetectionsMetrics(eval);
+    SaveConfusionMatrices(eval);
+
+    std::cout << std::endl;
+    return 0;
+}
+
+// Evaluation of a single test set in the cross validation
+struct TestSetRun
+{
+    std::string Folder;
+    Evaluation::EvaluationAccumulator Accumulator;
+    long long Milliseconds = 0;
+};
+
+// Print (and write to the CSV) a row of the cross validation table
+void PrintCrossValidationRow(const std::string& name, const Evaluation::AlgorithmEvaluation& eval, long long milliseconds, std::ofstream& fs)
+{
+    std::cout << std::setw(14) << std::setfill(' ') << name;
+    std::cout << std::setw(8) << std::setfill(' ') << eval.Evaluations.size();
+    std::cout << std::setw(10) << std::setfill(' ') << eval.TotalNumberDetected;
+    std::cout << std::setw(10) << std::setfill(' ') << eval.TotalNumberOfActualFumaroles;
+    std::cout << std::setw(12) << std::setfill(' ') << eval.TotalAverageIoU;
+    std::cout << std::setw(12) << std::setfill(' ') << eval.Matching.MeanAveragePrecision;
+    std::cout << std::setw(12) << std::setfill(' ') << eval.Matching.MeanAveragePrecision50;
+    std::cout << std::setw(12) << std::setfill(' ') << eval.ConfusionMatrix.GetAccuracy() * 100;
+    std::cout << std::setw(12) << std::setfill(' ') << milliseconds;
+    std::cout << std::endl;
+
+    fs << "\n" << name << "," << eval.Evaluations.size() << "," << eval.TotalNumberDetected << "," << eval.TotalNumberOfActualFumaroles << ",";
+    fs << eval.TotalAverageIoU << "," << eval.Matching.MeanAveragePrecision << "," << eval.Matching.MeanAveragePrecision50 << ",";
+    fs << eval.ConfusionMatrix.GetAccuracy() << "," << milliseconds;
+}
+
+// Run the test sets concurrently and report each set and all of them pooled
+int CrossValidate(std::vector<std::string> folders)
+{
+    if (folders.empty()) {
+        folders = TEST_SETS;
+    }
+
+    for (std::string& folder : folders) {
+        if (folder.back() != '/') {
+            folder += "/";
+        }
+    }
+
+    Evaluation::AlgorithmEvaluator evaluator;
+
+    // sets that share images only decode them once
+    IO::ImageCache imageCache(Config::ConfigParser::GetInstance().GetValue<size_t>("config.cache.max_image_bytes", IMAGE_CACHE_MAX_BYTES));
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::future<TestSetRun>> pending;
+    for (const std::string& folder : folders)
+    {
+        pending.emplace_back(std::async(std::launch::async, [&evaluator, &imageCache, folder]() {
+            TestSetRun run;
+            run.Folder = folder;
+
+            auto setStart = std::chrono::steady_clock::now();
+
+            std::map<std::string, std::string> files;
+            std::map<std::string, std::vector<Detection::FumaroleDetection>> setTruth;
+            IO::DatasetLoader::LoadTestData(folder, files, setTruth);
+
+            // image IDs are prefixed with the set so the pooled evaluation keeps images of different sets apart
+            std::map<std::string, std::string> testFiles;
+            std::map<std::string, std::vector<Detection::FumaroleDetection>> groundTruth;
+            for (auto& file : files) {
+                testFiles[folder + file.first] = file.second;
+            }
+            for (auto& y : setTruth) {
+                groundTruth[folder + y.first] = std::move(y.second);
+            }
+
+            Detection::FumaroleDetector detector(false);
+            detector.SetImageLoader([&imageCache](const std::string& path, cv::Mat& image) { return imageCache.Load(path, image); });
+
+            std::map<std::string, std::vector<Detection::FumaroleDetection>> results;
+            detector.DetectFumaroles(testFiles, results);
+
+            run.Accumulator = evaluator.AccumulateDetectionPipeline(results, groundTruth);
+            run.Milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - setStart).count();
+
+            return run;
+        }));
+    }
+
+    std::vector<TestSetRun> runs;
+    for (std::future<TestSetRun>& run : pending) {
+        runs.emplace_back(run.get());
+    }
+
+    const long long wallTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    // per set and pooled metrics side by side
+    std::ofstream fs;
+    fs.open(CROSS_VALIDATION_FILE_NAME, std::ios::out);
+    fs << "Test Set,Images,Detected,Actual,Avg IoU,mAP,mAP50,Class Accuracy,Time (ms)";
+
+    std::cout << "\n\n--------------- Cross Validation ---------------\n";
+    std::cout << std::setw(14) << std::setfill(' ') << "\nTest Set";
+    std::cout << std::setw(8) << std::setfill(' ') << "Images";
+    std::cout << std::setw(10) << std::setfill(' ') << "Detected";
+    std::cout << std::setw(10) << std::setfill(' ') << "Actual";
+    std::cout << std::setw(12) << std::setfill(' ') << "Avg IoU";
+    std::cout << std::setw(12) << std::setfill(' ') << "mAP";
+    std::cout << std::setw(12) << std::setfill(' ') << "mAP50";
+    std::cout << std::setw(12) << std::setfill(' ') << "Class Acc %";
+    std::cout << std::setw(12) << std::setfill(' ') << "Time (ms)";
+    std::cout << std::endl;
+
+    Evaluation::EvaluationAccumulator pooled;
+    for (const TestSetRun& run : runs)
+    {
+        PrintCrossValidationRow(run.Folder, run.Accumulator.Finalize(), run.Milliseconds, fs);
+        pooled.Merge(run.Accumulator);
+    }
+
+    PrintCrossValidationRow("pooled", pooled.Finalize(), wallTime, fs);
+    fs.close();
+
+    std::cout << "\nDecoded " << imageCache.GetMisses() << " images (" << imageCache.GetHits() << " loads served from the image cache)" << std::endl;
+    return 0;
+}
+
+// Measure the per-frame latency of a detector session
+int MeasureSessionLatency(const std::string& folder)
+{
+    std::map<std::string, std::string> testFiles;
+    std::map<std::string, std::vector<Detection::FumaroleDetection>> groundTruth;
+    IO::DatasetLoader::LoadTestData(folder, testFiles, groundTruth);
+
+    // decode up front so only the detection is timed
+    std::vector<cv::Mat> frames;
+    for (const auto& file : testFiles)
+    {
+        cv::Mat frame = cv::imread(file.second, cv::IMREAD_GRAYSCALE);
+        if (frame.data) {
+            frames.push_back(frame);
+        }
+    }
+
+    if (frames.empty()) {
+        std::cerr << "\nNo frames to measure in " << folder << std::endl;
+        return 1;
+    }
+
+    Detection::DetectorSession session;
+    std::vector<Detection::FumaroleDetection> detections;
+
+    // the first frames allocate the buffers of the session
+    for (int i = 0; i < LATENCY_WARMUP_FRAMES; i++) {
+        session.Detect(frames[i % frames.size()], detections);
+    }
+
+    session.ResetLatencySummary();
+
+    for (int pass = 0; pass < LATENCY_PASSES; pass++)
+    {
+        for (const cv::Mat& frame : frames) {
+            session.Detect(frame, detections);
+        }
+    }
+
+    std::cout << "\nFrames of " << folder << " (" << frames.front().cols << "x" << frames.front().rows << ")";
+    std::cout << session.GetLatencySummary();
+
+    return 0;
 }
@@ -0,0 +1,115 @@
+//
+// track_synthetic.cpp
+// Runs the frame-to-frame tracker on a synthetic sequence of moving vents with a dropout of all detections
+// Checks that every vent keeps its track ID and prints the time per frame and the tracker stats
+//
+
+#include "detection/FumaroleTracker.hpp"
+#include "detection/FumaroleDetection.hpp"
+#include "config/DetectorConfig.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+const int VENT_COUNT { 200 };
+const int VENTS_PER_ROW { 20 };
+const int VENT_SPACING { 100 };
+const int VENT_SIZE { 10 };
+const int FRAME_COUNT { 1000 };
+
+// the vents move by this many pixels per frame
+const int MOTION_X { 2 };
+const int MOTION_Y { 1 };
+
+// no vent is detected in these frames (e.g. the camera is covered by steam)
+const int DROPOUT_FIRST { 10 };
+const int DROPOUT_LAST { 12 };
+
+// Index of the vent a detection of the given frame belongs to
+int VentOf(const Detection::FumaroleDetection& detection, int frame)
+{
+    const int column = (detection.BoundingBox.x - MOTION_X * frame) / VENT_SPACING;
+    const int row = (detection.BoundingBox.y - MOTION_Y * frame) / VENT_SPACING;
+
+    return row * VENTS_PER_ROW + column;
+}
+
+int main()
+{
+    Config::TrackingConfig config;
+    config.GateRadius = 40.0f;
+    config.MaxMissedFrames = 5;
+    config.VelocitySmoothing = 0.5f;
+
+    Detection::FumaroleTracker tracker(config);
+
+    // the detections of a frame arrive in no particular order
+    std::mt19937 random(1);
+
+    std::vector<uint64_t> trackIDs;
+    std::vector<uint64_t> firstTrackIDs;
+    std::vector<uint64_t> ventTrackIDs(VENT_COUNT);
+    std::vector<Detection::FumaroleDetection> detections;
+
+    int unstableFrames = 0;
+    double totalMilliseconds = 0.0;
+    double maxMilliseconds = 0.0;
+
+    for (int frame = 0; frame < FRAME_COUNT; frame++)
+    {
+        detections.clear();
+
+        if (frame < DROPOUT_FIRST || frame > DROPOUT_LAST)
+        {
+            for (int vent = 0; vent < VENT_COUNT; vent++)
+            {
+                Detection::FumaroleDetection detection;
+                detection.Type = Model::FUMAROLE_HOLE;
+                detection.BoundingBox = cv::Rect((vent % VENTS_PER_ROW) * VENT_SPACING + MOTION_X * frame,
+                                                 (vent / VENTS_PER_ROW) * VENT_SPACING + MOTION_Y * frame, VENT_SIZE, VENT_SIZE);
+                detections.push_back(detection);
+            }
+
+            std::shuffle(detections.begin(), detections.end(), random);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        tracker.Update(detections, trackIDs);
+        auto end = std::chrono::steady_clock::now();
+
+        const double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+        totalMilliseconds += milliseconds;
+        maxMilliseconds = std::max(maxMilliseconds, milliseconds);
+
+        if (detections.empty()) {
+            continue;
+        }
+
+        for (size_t i = 0; i < detections.size(); i++) {
+            ventTrackIDs[VentOf(detections[i], frame)] = trackIDs[i];
+        }
+
+        // every vent has to keep the track ID of the first frame
+        if (firstTrackIDs.empty()) {
+            firstTrackIDs = ventTrackIDs;
+        }
+        else if (ventTrackIDs != firstTrackIDs) {
+            unstableFrames++;
+        }
+    }
+
+    std::cout << "\n--------------- Synthetic Tracking ---------------";
+    std::cout << "\nVents = " << VENT_COUNT;
+    std::cout << "\nFrames = " << FRAME_COUNT;
+    std::cout << "\nDropout frames = " << DROPOUT_FIRST << " - " << DROPOUT_LAST;
+    std::cout << "\nFrames with changed IDs = " << unstableFrames;
+    std::cout << "\nAverage time per frame (ms) = " << totalMilliseconds / FRAME_COUNT;
+    std::cout << "\nMax time per frame (ms) = " << maxMilliseconds;
+    std::cout << std::endl;
+    std::cout << tracker.GetStats();
+
+    return (unstableFrames == 0 ? 0 : 1);
+}